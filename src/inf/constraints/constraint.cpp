@@ -208,10 +208,10 @@ inf::Constraint::EvaluatorPair inf::Constraint::get_marg_evaluators() const {
                                        m_rhs_inflation_marginal->get_evaluator());
 
     // LHS
-    ret.first.set_dual_vector_reference(&m_lhs_dual_vector->get_event_tensor());
+    ret.first.set_dual_vector_reference(m_lhs_dual_vector.get());
     ret.first.set_scale_reference(&m_lhs_scale);
     // RHS
-    ret.second.set_dual_vector_reference(&m_rhs_reduced_dual_vector->get_event_tensor());
+    ret.second.set_dual_vector_reference(m_rhs_reduced_dual_vector.get());
     ret.second.set_scale_reference(&m_rhs_scale);
 
     return ret;
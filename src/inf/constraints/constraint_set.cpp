@@ -2,6 +2,10 @@
 #include "../../util/logger.h"
 #include "../../util/math.h"
 #include "dual_vector.h"
+// For std::max
+#include <algorithm>
+// For std::abs
+#include <cstdlib>
 // For exact arithmetic
 #include <gmp.h>
 
@@ -14,7 +18,9 @@ inf::ConstraintSet::ConstraintSet(inf::Inflation::ConstPtr const &inflation,
       m_quovec_size(0),
       // Arithmetic
       m_quovec_denom(1.0),
-      m_max_dual_vector_component(0) {
+      m_max_dual_vector_component(0),
+      m_inner_product_scale(0),
+      m_n_target_distribution_updates(0) {
 
     util::logger << "Constructing inf::ConstraintSet..." << util::cr;
 
@@ -77,6 +83,33 @@ Num inf::ConstraintSet::get_max_dual_vector_component() const {
     return m_max_dual_vector_component;
 }
 
+Num inf::ConstraintSet::get_max_inner_product(inf::Quovec const &quovec) const {
+    ASSERT_EQUAL(quovec.size(), get_quovec_size())
+
+    Num max_abs_component = 0;
+    for (Num const component : quovec)
+        max_abs_component = std::max(max_abs_component, std::abs(component));
+
+    return m_inner_product_scale * max_abs_component;
+}
+
+inf::Quovec inf::ConstraintSet::get_quovec() const {
+    inf::Quovec ret(m_quovec_size);
+
+    Index offset = 0;
+    for (inf::Constraint::UniquePtr const &constraint : m_constraints) {
+        constraint->get_dual_vector().get_quovec(ret, offset);
+        offset += constraint->get_quovec_size();
+    }
+    ASSERT_EQUAL(offset, get_quovec_size())
+
+    return ret;
+}
+
+Index inf::ConstraintSet::get_n_target_distribution_updates() const {
+    return m_n_target_distribution_updates;
+}
+
 inf::Marginal::EvaluatorSet inf::ConstraintSet::get_marg_evaluators() const {
     std::vector<inf::Marginal::Evaluator> evaluators{};
 
@@ -86,7 +119,7 @@ inf::Marginal::EvaluatorSet inf::ConstraintSet::get_marg_evaluators() const {
         evaluators.emplace_back(evaluator_pair.second);
     }
 
-    return inf::Marginal::EvaluatorSet(evaluators);
+    return inf::Marginal::EvaluatorSet(evaluators, m_store_bounds);
 }
 
 // Setters
@@ -95,6 +128,7 @@ void inf::ConstraintSet::set_target_distribution(inf::TargetDistr const &d) {
     for (inf::Constraint::UniquePtr &constraint : m_constraints) {
         constraint->set_target_distribution(d);
     }
+    ++m_n_target_distribution_updates;
 
     update_constraint_scale_factors();
 }
@@ -269,7 +303,8 @@ void inf::ConstraintSet::update_constraint_scale_factors() {
     // Just to be safe
     Num const safety_factor = 10;
 
-    Num const divide_by = safety_factor * util::mpz_to_ll(scale_factors[0]) * m_constraints[0]->get_lhs_denom() * 2 * static_cast<Num>(m_constraints.size());
+    m_inner_product_scale = util::mpz_to_ll(scale_factors[0]) * m_constraints[0]->get_lhs_denom() * 2 * static_cast<Num>(m_constraints.size());
+    Num const divide_by = safety_factor * m_inner_product_scale;
 
     m_max_dual_vector_component /= divide_by;
 
@@ -72,6 +72,16 @@ class ConstraintSet : public util::Loggable {
     Index get_quovec_size() const;
     /*! \brief The max overflow-safe value that can be held by a dual vector */
     Num get_max_dual_vector_component() const;
+    /*! \brief An upper bound on the absolute value of the inner product of \p quovec with any inflation event
+     * \details This is \f$2 |\constraintlist| \scaletot \max_i |\quovec_i|\f$, where \f$\scaletot\f$ is the total scale factor (see inf::ConstraintSet::get_quovec_denom()):
+     * both sides of each constraint contribute at most \f$\scaletot \max_i |\quovec_i|\f$ to the inner products returned by inf::Marginal::EvaluatorSet::evaluate_dual_vector().
+     * Applied to the difference of two quovecs, this bounds the change of the score of any inflation event, see inf::TreeOpt. */
+    Num get_max_inner_product(inf::Quovec const &quovec) const;
+    /*! \brief The current quovec \f$\{\quovec_\constraintname\}_{\constraintname\in\constraintlist} \in \totquovecspace\f$, as passed to inf::ConstraintSet::set_dual_vector_from_quovec() */
+    inf::Quovec get_quovec() const;
+    /*! \brief The number of calls to inf::ConstraintSet::set_target_distribution()
+     * \details Changing the target distribution changes the inner products of a given quovec, so this allows to know whether two quovecs can be compared. */
+    Index get_n_target_distribution_updates() const;
     /*! \brief The set of inf::Marginal::Evaluator, allowing to efficiently evaluate inner products */
     inf::Marginal::EvaluatorSet get_marg_evaluators() const;
 
@@ -158,6 +168,10 @@ class ConstraintSet : public util::Loggable {
     double m_quovec_denom;
     /*! \brief This is the maximal value a dual vector entry can take to be guaranteed to never overflow, see inf::ConstraintSet::check_quovec_for_overflow() */
     Num m_max_dual_vector_component;
+    /*! \brief This is \f$2 |\constraintlist| \scaletot\f$, see inf::ConstraintSet::get_max_inner_product() */
+    Num m_inner_product_scale;
+    /*! \brief See inf::ConstraintSet::get_n_target_distribution_updates() */
+    Index m_n_target_distribution_updates;
     /*! \brief This arithmetic method looks at the denominators of the LHS and RHS of each constraint, simplifies where possible, and assigns the appropriate scale factors to the constraints
      * \details The way this method works is explained in the paper. */
     void update_constraint_scale_factors();
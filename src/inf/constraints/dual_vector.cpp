@@ -46,12 +46,17 @@ inf::DualVector::DualVector(inf::Marginal const &marginal,
       m_event_to_quovec_index{},
       // -----------------------
       m_bound_type(bound_type),
+      m_n_updates(0),
+      // This is resized once the orbits are known
+      m_orbit_coeffs{},
       // These are initialized in init_bound_rules()
       m_bound_rules{} {
 
     init_orbits(marginal.get_marginal_symmetries());
 
     init_quovec_index_maps();
+    // A scalar dual vector has no orbits but one coefficient, see inf::DualVector::set_from_quovec()
+    m_orbit_coeffs.resize(get_n_parties() == 0 ? 1 : get_n_orbits(), 0);
 
     init_bound_rules();
 }
@@ -66,7 +71,17 @@ std::vector<inf::QuovecIndex> const &inf::DualVector::get_event_to_quovec_index(
     return m_event_to_quovec_index;
 }
 
+inf::Quovec const &inf::DualVector::get_orbit_coeffs() const {
+    return m_orbit_coeffs;
+}
+
+Index const &inf::DualVector::get_n_updates() const {
+    return m_n_updates;
+}
+
 void inf::DualVector::set_from_quovec(inf::Quovec const &quovec, inf::QuovecIndex start_pos) {
+    ++m_n_updates;
+
     // If we have a scalar dual_vector, expect a single coefficient
     if (get_n_parties() == 0) {
         // We could in principle allow to read the coefficient in the list,
@@ -76,6 +91,7 @@ void inf::DualVector::set_from_quovec(inf::Quovec const &quovec, inf::QuovecInde
         ASSERT_EQUAL(quovec.size(), 1)
 
         m_event_tensor.get_num(0) = quovec[0];
+        m_orbit_coeffs[0] = quovec[0];
 
         return;
     }
@@ -89,18 +105,13 @@ void inf::DualVector::set_from_quovec(inf::Quovec const &quovec, inf::QuovecInde
 
     // The rest is only executed when we store the bounds
     if (m_store_bounds == inf::DualVector::StoreBounds::yes) {
-        inf::Quovec quovec_with_unknown(get_n_orbits_with_unknown());
-        for (Index const i : util::Range(m_n_orbits_no_unknown)) {
-            quovec_with_unknown[i] = quovec[start_pos + i];
-        }
-
         for (BoundRule const &bound_rule : m_bound_rules) {
 
             // Easter egg, this value is unused
             Num bound = 42;
 
             for (Index i : util::Range(bound_rule.second.size())) {
-                Num const potential_bound = quovec_with_unknown[bound_rule.second[i]];
+                Num const potential_bound = m_orbit_coeffs[bound_rule.second[i]];
 
                 if (i == 0)
                     bound = potential_bound;
@@ -108,13 +119,25 @@ void inf::DualVector::set_from_quovec(inf::Quovec const &quovec, inf::QuovecInde
                     bound = min_or_max(bound, potential_bound);
             }
 
-            quovec_with_unknown[bound_rule.first] = bound;
-
             set_orbit_coeff(bound_rule.first, bound);
         }
     }
 }
 
+void inf::DualVector::get_quovec(inf::Quovec &quovec, inf::QuovecIndex start_pos) const {
+    // See inf::DualVector::set_from_quovec()
+    if (get_n_parties() == 0) {
+        quovec[start_pos] = m_event_tensor.get_num(0);
+        return;
+    }
+
+    ASSERT_LT(m_n_orbits_no_unknown, quovec.size() - start_pos + 1);
+
+    // All the events of an orbit have the same coefficient
+    for (inf::QuovecIndex const quovec_index : util::Range(m_n_orbits_no_unknown))
+        quovec[start_pos + quovec_index] = m_event_tensor.get_num(m_quovec_index_to_orbit[quovec_index][0]);
+}
+
 void inf::DualVector::hard_assert_within_bound(Num const bound) const {
     for (inf::Event const &orbit_repr : get_orbit_repr_no_unknown()) {
         Num const component = get_event_tensor().get_num(orbit_repr);
@@ -273,6 +296,7 @@ void inf::DualVector::set_orbit_coeff(inf::QuovecIndex quovec_index, Num coeff)
     ASSERT_TRUE(orbits_initialized())
     ASSERT_LT(quovec_index, get_n_orbits())
 
+    m_orbit_coeffs[quovec_index] = coeff;
     for (inf::EventTensor::EventHash const event_hash : m_quovec_index_to_orbit[quovec_index]) {
         m_event_tensor.get_num(event_hash) = coeff;
     }
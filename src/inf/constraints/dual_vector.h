@@ -134,6 +134,11 @@ class DualVector : public inf::TensorWithOrbits, public util::Serializable {
      * The representatives are then ordered and assigned an index `m_event_to_quovec_index[i]`. */
     std::vector<inf::QuovecIndex> const &get_event_to_quovec_index() const;
 
+    /*! \brief The coefficient of each orbit, indexed by quovec index, including the bounds assigned to the orbits with unknown outcomes
+     * \details This is a compact version of the underlying inf::EventTensor: the marginal event with hash `i` has the coefficient
+     * `get_orbit_coeffs()[get_event_to_quovec_index()[i]]`. */
+    inf::Quovec const &get_orbit_coeffs() const;
+
     /*! \brief This sets the coefficients (image) of the inf::DualVector, including bounds if necessary
      * \details The idea is that the underlying `m_event_tensor` (an inf::EventTensor) will have its coefficients set as
      * `m_event_tensor[j] = quovec[start_pos + i]`, where `i = get_event_to_quovec_index()[j]`,
@@ -152,6 +157,15 @@ class DualVector : public inf::TensorWithOrbits, public util::Serializable {
      * when we deal with a set of constraints \f$\constraintlist \subset \infconstraints\f$. */
     void set_from_quovec(inf::Quovec const &quovec, inf::QuovecIndex start_pos);
 
+    /*! \brief The number of times that the coefficients were modified, i.e., the number of calls to inf::DualVector::set_from_quovec()
+     * \details This is returned as a reference so that an inf::Marginal::EvaluatorSet can tell whether the coefficients changed
+     * since it last copied them, see inf::Marginal::Evaluator::set_dual_vector_reference(). */
+    Index const &get_n_updates() const;
+
+    /*! \brief This is the inverse of inf::DualVector::set_from_quovec(): it writes the coefficients of each orbit (without unknown outcomes)
+     * to \p quovec, starting at \p start_pos */
+    void get_quovec(inf::Quovec &quovec, inf::QuovecIndex start_pos) const;
+
     /*! \brief This hard-asserts that the dual vector's components are less than the specified \p bound in absolute value
      * \param bound Denoted \f$B\f$ in the paper */
     void hard_assert_within_bound(Num const bound) const;
@@ -205,6 +219,7 @@ class DualVector : public inf::TensorWithOrbits, public util::Serializable {
     void init_quovec_index_maps();
 
     /*! \brief To set all the coefficients of an orbit to the same value, used in inf::DualVector::set_from_quovec()
+     * \details This sets both `m_orbit_coeffs[quovec_index]` and the coefficients of the underlying inf::EventTensor.
      * \param quovec_index Identifies an orbit \f$o_{\infevent} = \act{\marggroup}{\events\infmarg}(\infevent)\f$
      * \param coeff The value to assign as the image of each \f$\infevent' \in o_{\infevent}\f$ */
     void set_orbit_coeff(inf::QuovecIndex quovec_index, Num coeff);
@@ -213,6 +228,11 @@ class DualVector : public inf::TensorWithOrbits, public util::Serializable {
      * \details If `m_store_bounds == inf::DualVector::StoreBounds::no`, this is ignored. */
     inf::DualVector::BoundType m_bound_type;
 
+    /*! \brief See inf::DualVector::get_n_updates() */
+    Index m_n_updates;
+    /*! \brief See inf::DualVector::get_orbit_coeffs() */
+    inf::Quovec m_orbit_coeffs;
+
     /*! \brief This type describes how to compute upper/lower bounds: `bound_rule.first` is the quovec index to set as the min/max of
      * the quovec elements indexed by `bound_rule.second`
      * \details In principle, we could simply say that the event `(0,?)` computes its bounds based on the min/max of the values assigned
@@ -1,8 +1,16 @@
 #include "marginal.h"
 #include "../../util/debug.h"
 #include "../../util/logger.h"
+#include "../../util/math.h"
 #include "dual_vector.h"
 
+// For std::max
+#include <algorithm>
+// For std::abs
+#include <cstdlib>
+// For std::numeric_limits
+#include <limits>
+
 // inf::Marginal::Permutation
 
 bool inf::Marginal::Permutation::operator<(inf::Marginal::Permutation const &other) const {
@@ -31,13 +39,19 @@ inf::Marginal::Evaluator::Evaluator(Index n_inflation_parties,
       m_marg_event_hashes(n_marg_perms, Index(0)),
       m_party_to_update_rules(party_to_update_rules),
       m_dual_vector(nullptr),
+      m_n_dual_vector_updates(nullptr),
+      m_orbit_coeffs(nullptr),
+      m_event_to_quovec_index(nullptr),
       m_scale(nullptr) {}
 
-void inf::Marginal::Evaluator::set_dual_vector_reference(inf::EventTensor const *dual_vector) {
+void inf::Marginal::Evaluator::set_dual_vector_reference(inf::DualVector const *dual_vector) {
     ASSERT_TRUE(m_dual_vector == nullptr)
     ASSERT_TRUE(dual_vector != nullptr)
-    ASSERT_EQUAL(dual_vector->get_n_parties(), m_n_marginal_parties)
-    m_dual_vector = dual_vector;
+    ASSERT_EQUAL(dual_vector->get_event_tensor().get_n_parties(), m_n_marginal_parties)
+    m_dual_vector = &dual_vector->get_event_tensor();
+    m_n_dual_vector_updates = &dual_vector->get_n_updates();
+    m_orbit_coeffs = &dual_vector->get_orbit_coeffs();
+    m_event_to_quovec_index = &dual_vector->get_event_to_quovec_index();
 }
 
 void inf::Marginal::Evaluator::set_scale_reference(Num const *scale) {
@@ -86,24 +100,366 @@ inf::Event const &inf::Marginal::Evaluator::get_inflation_event() const {
 
 // inf::Marginal::EvaluatorSet
 
-inf::Marginal::EvaluatorSet::EvaluatorSet(std::vector<inf::Marginal::Evaluator> const &evaluators)
-    : m_evaluators(evaluators) {}
+inf::Marginal::EvaluatorSet::EvaluatorSet(std::vector<inf::Marginal::Evaluator> const &evaluators, inf::DualVector::StoreBounds store_bounds)
+    : m_inflation_event(),
+      m_n_outcomes(0),
+      m_n_known_outcomes(0),
+      m_party_first_rule{},
+      m_rule_slots{},
+      m_rule_hash_steps{},
+      m_slot_hashes{},
+      m_arena_indices(nullptr),
+      m_arena_size(0),
+      // Initialized below
+      m_outcomes_kernel(nullptr),
+      m_set_outcome_kernel(nullptr),
+      m_sources{},
+      m_arena_width(inf::Marginal::EvaluatorSet::ArenaWidth::int64),
+      m_dual_vector_arena_16{},
+      m_dual_vector_arena_32{},
+      m_dual_vector_arena_64{},
+      m_slot_values{},
+      m_running_score(0) {
+
+    HARD_ASSERT_LT(Index(0), evaluators.size())
+
+    m_inflation_event = evaluators[0].m_inflation_event;
+    m_n_outcomes = evaluators[0].m_n_outcomes;
+    m_n_known_outcomes = store_bounds == inf::DualVector::StoreBounds::yes ? m_n_outcomes - 1 : m_n_outcomes;
+    Index const n_inflation_parties = m_inflation_event.size();
+
+    // The slots, the arena segments and the hashes, one segment per inf::Marginal::Evaluator
+    std::vector<Index> first_slots;
+    std::vector<Index> arena_indices;
+    for (inf::Marginal::Evaluator const &evaluator : evaluators) {
+        HARD_ASSERT_EQUAL(evaluator.m_inflation_event, m_inflation_event)
+        HARD_ASSERT_EQUAL(evaluator.m_n_outcomes, m_n_outcomes)
+        HARD_ASSERT_TRUE(evaluator.m_dual_vector != nullptr)
+        HARD_ASSERT_TRUE(evaluator.m_scale != nullptr)
+
+        Index const arena_offset = m_arena_size;
+        m_sources.push_back(inf::Marginal::EvaluatorSet::Source{evaluator.m_orbit_coeffs,
+                                                                evaluator.m_n_dual_vector_updates,
+                                                                evaluator.m_scale,
+                                                                arena_offset,
+                                                                0,
+                                                                0});
+        m_arena_size += evaluator.m_orbit_coeffs->size();
+
+        // One arena index per marginal event
+        HARD_ASSERT_EQUAL(evaluator.m_event_to_quovec_index->size(),
+                          util::pow(static_cast<Index>(evaluator.m_dual_vector->get_base()), evaluator.m_dual_vector->get_n_parties()))
+        Index const hash_offset = arena_indices.size();
+        if (evaluator.m_is_scalar_marginal) {
+            // The only marginal event is mapped to the only coefficient
+            HARD_ASSERT_EQUAL(evaluator.m_orbit_coeffs->size(), 1)
+            arena_indices.push_back(arena_offset);
+        } else {
+            for (inf::QuovecIndex const quovec_index : *evaluator.m_event_to_quovec_index) {
+                HARD_ASSERT_LT(quovec_index, evaluator.m_orbit_coeffs->size())
+                arena_indices.push_back(arena_offset + quovec_index);
+            }
+        }
 
-Num inf::Marginal::EvaluatorSet::evaluate_dual_vector() const {
-    Num ret = 0;
-    for (inf::Marginal::Evaluator const &evaluator : m_evaluators)
-        ret += evaluator.evaluate_dual_vector();
+        first_slots.push_back(m_slot_hashes.size());
+        if (evaluator.m_is_scalar_marginal) {
+            // A single term that no inflation party affects
+            m_slot_hashes.push_back(static_cast<inf::Marginal::EvaluatorSet::TableIndex>(hash_offset));
+        } else {
+            for (Index const marg_event_hash : evaluator.m_marg_event_hashes)
+                m_slot_hashes.push_back(static_cast<inf::Marginal::EvaluatorSet::TableIndex>(hash_offset + marg_event_hash));
+        }
+    }
+
+    // Every hash, arena index, slot and hash step is smaller than these
+    HARD_ASSERT_LTE(arena_indices.size(), static_cast<Index>(std::numeric_limits<inf::Marginal::EvaluatorSet::TableIndex>::max()))
+    HARD_ASSERT_LTE(m_slot_hashes.size(), static_cast<Index>(std::numeric_limits<inf::Marginal::EvaluatorSet::TableIndex>::max()))
+
+    m_arena_indices = std::make_shared<std::vector<inf::Marginal::EvaluatorSet::TableIndex> const>(arena_indices.begin(), arena_indices.end());
+
+    // The update rules, grouped by inflation party
+    for (Index const inflation_party : util::Range(n_inflation_parties)) {
+        m_party_first_rule.push_back(m_rule_slots.size());
+
+        for (Index const i : util::Range(evaluators.size())) {
+            if (evaluators[i].m_is_scalar_marginal)
+                continue;
 
-    return ret;
+            for (inf::Marginal::Evaluator::UpdateRule const &update_rule : evaluators[i].m_party_to_update_rules[inflation_party]) {
+                HARD_ASSERT_EQUAL(update_rule.inverse_outcome_sym.size(), m_n_outcomes)
+
+                m_rule_slots.push_back(static_cast<inf::Marginal::EvaluatorSet::TableIndex>(first_slots[i] + update_rule.marg_perm_index));
+                for (inf::Outcome const marg_outcome : update_rule.inverse_outcome_sym)
+                    m_rule_hash_steps.push_back(static_cast<inf::Marginal::EvaluatorSet::TableIndex>(marg_outcome * update_rule.party_weight));
+            }
+        }
+    }
+    m_party_first_rule.push_back(m_rule_slots.size());
+
+    m_slot_values.resize(m_slot_hashes.size(), 0);
+
+    // Such that the arena is filled at the first evaluation
+    for (inf::Marginal::EvaluatorSet::Source &source : m_sources)
+        source.n_updates_seen = std::numeric_limits<Index>::max();
+
+    select_kernels();
 }
 
-void inf::Marginal::EvaluatorSet::set_outcome(Index const inflation_party, inf::Outcome const outcome) {
-    for (inf::Marginal::Evaluator &evaluator : m_evaluators)
-        evaluator.set_outcome(inflation_party, outcome);
+Num inf::Marginal::EvaluatorSet::evaluate_dual_vector() const {
+    if (not is_arena_up_to_date())
+        update_arena();
+
+    return m_running_score;
 }
 
 inf::Event const &inf::Marginal::EvaluatorSet::get_inflation_event() const {
-    return m_evaluators[0].get_inflation_event();
+    return m_inflation_event;
+}
+
+inf::Marginal::EvaluatorSet::ArenaWidth inf::Marginal::EvaluatorSet::get_arena_width() const {
+    return m_arena_width;
+}
+
+bool inf::Marginal::EvaluatorSet::is_arena_up_to_date() const {
+    for (inf::Marginal::EvaluatorSet::Source const &source : m_sources) {
+        if (source.n_updates_seen != *source.n_dual_vector_updates or source.scale_seen != *source.scale)
+            return false;
+    }
+    return true;
+}
+
+void inf::Marginal::EvaluatorSet::update_arena() const {
+    // The largest absolute value that the arena has to hold
+    Num max_value = 0;
+    for (inf::Marginal::EvaluatorSet::Source const &source : m_sources) {
+        Num const scale = *source.scale;
+        for (Num const orbit_coeff : *source.orbit_coeffs)
+            max_value = std::max(max_value, std::abs(scale * orbit_coeff));
+    }
+
+    inf::Marginal::EvaluatorSet::ArenaWidth const old_arena_width = m_arena_width;
+
+    // Only one of the vectors holds the arena
+    if (max_value <= std::numeric_limits<std::int16_t>::max()) {
+        m_arena_width = inf::Marginal::EvaluatorSet::ArenaWidth::int16;
+        fill_arena(m_dual_vector_arena_16);
+        m_dual_vector_arena_32 = std::vector<std::int32_t>();
+        m_dual_vector_arena_64 = std::vector<Num>();
+    } else if (max_value <= std::numeric_limits<std::int32_t>::max()) {
+        m_arena_width = inf::Marginal::EvaluatorSet::ArenaWidth::int32;
+        fill_arena(m_dual_vector_arena_32);
+        m_dual_vector_arena_16 = std::vector<std::int16_t>();
+        m_dual_vector_arena_64 = std::vector<Num>();
+    } else {
+        m_arena_width = inf::Marginal::EvaluatorSet::ArenaWidth::int64;
+        fill_arena(m_dual_vector_arena_64);
+        m_dual_vector_arena_16 = std::vector<std::int16_t>();
+        m_dual_vector_arena_32 = std::vector<std::int32_t>();
+    }
+
+    if (m_arena_width != old_arena_width)
+        select_kernels();
+
+    for (inf::Marginal::EvaluatorSet::Source &source : m_sources) {
+        source.n_updates_seen = *source.n_dual_vector_updates;
+        source.scale_seen = *source.scale;
+    }
+}
+
+template <typename Value>
+void inf::Marginal::EvaluatorSet::fill_arena(std::vector<Value> &arena) const {
+    arena.resize(m_arena_size);
+
+    for (inf::Marginal::EvaluatorSet::Source const &source : m_sources) {
+        Num const scale = *source.scale;
+        inf::Quovec const &orbit_coeffs = *source.orbit_coeffs;
+        for (Index i(0); i < orbit_coeffs.size(); ++i)
+            arena[source.arena_offset + i] = static_cast<Value>(scale * orbit_coeffs[i]);
+    }
+
+    inf::Marginal::EvaluatorSet::TableIndex const *const arena_indices = m_arena_indices->data();
+    m_running_score = 0;
+    for (Index const slot : util::Range(m_slot_hashes.size())) {
+        m_slot_values[slot] = arena[arena_indices[m_slot_hashes[slot]]];
+        m_running_score += m_slot_values[slot];
+    }
+}
+
+template <>
+std::int16_t const *inf::Marginal::EvaluatorSet::get_arena<std::int16_t>() const {
+    return m_dual_vector_arena_16.data();
+}
+
+template <>
+std::int32_t const *inf::Marginal::EvaluatorSet::get_arena<std::int32_t>() const {
+    return m_dual_vector_arena_32.data();
+}
+
+template <>
+Num const *inf::Marginal::EvaluatorSet::get_arena<Num>() const {
+    return m_dual_vector_arena_64.data();
+}
+
+void inf::Marginal::EvaluatorSet::select_kernels() const {
+    switch (m_arena_width) {
+    case inf::Marginal::EvaluatorSet::ArenaWidth::int16:
+        select_kernels_for<std::int16_t>();
+        break;
+    case inf::Marginal::EvaluatorSet::ArenaWidth::int32:
+        select_kernels_for<std::int32_t>();
+        break;
+    case inf::Marginal::EvaluatorSet::ArenaWidth::int64:
+        select_kernels_for<Num>();
+        break;
+    }
+}
+
+template <typename Value>
+void inf::Marginal::EvaluatorSet::select_kernels_for() const {
+    // Two to four outcomes, plus the unknown outcome if the dual vectors store bounds
+    switch (m_n_outcomes * 8 + m_n_known_outcomes) {
+    case 2 * 8 + 2:
+        m_outcomes_kernel = &inf::Marginal::EvaluatorSet::evaluate_all_outcomes<Value, 2, 2>;
+        m_set_outcome_kernel = &inf::Marginal::EvaluatorSet::set_outcome_kernel<Value, 2>;
+        break;
+    case 3 * 8 + 3:
+        m_outcomes_kernel = &inf::Marginal::EvaluatorSet::evaluate_all_outcomes<Value, 3, 3>;
+        m_set_outcome_kernel = &inf::Marginal::EvaluatorSet::set_outcome_kernel<Value, 3>;
+        break;
+    case 4 * 8 + 4:
+        m_outcomes_kernel = &inf::Marginal::EvaluatorSet::evaluate_all_outcomes<Value, 4, 4>;
+        m_set_outcome_kernel = &inf::Marginal::EvaluatorSet::set_outcome_kernel<Value, 4>;
+        break;
+    case 3 * 8 + 2:
+        m_outcomes_kernel = &inf::Marginal::EvaluatorSet::evaluate_all_outcomes<Value, 3, 2>;
+        m_set_outcome_kernel = &inf::Marginal::EvaluatorSet::set_outcome_kernel<Value, 3>;
+        break;
+    case 4 * 8 + 3:
+        m_outcomes_kernel = &inf::Marginal::EvaluatorSet::evaluate_all_outcomes<Value, 4, 3>;
+        m_set_outcome_kernel = &inf::Marginal::EvaluatorSet::set_outcome_kernel<Value, 4>;
+        break;
+    case 5 * 8 + 4:
+        m_outcomes_kernel = &inf::Marginal::EvaluatorSet::evaluate_all_outcomes<Value, 5, 4>;
+        m_set_outcome_kernel = &inf::Marginal::EvaluatorSet::set_outcome_kernel<Value, 5>;
+        break;
+    default:
+        m_outcomes_kernel = &inf::Marginal::EvaluatorSet::evaluate_outcomes<Value>;
+        m_set_outcome_kernel = &inf::Marginal::EvaluatorSet::set_outcome_kernel<Value, 0>;
+        break;
+    }
+}
+
+Num inf::Marginal::EvaluatorSet::get_score_without_party(Index const inflation_party) const {
+    ASSERT_LT(inflation_party, m_inflation_event.size())
+
+    Num score = m_running_score;
+    Index const end_rule = m_party_first_rule[inflation_party + 1];
+    for (Index rule(m_party_first_rule[inflation_party]); rule < end_rule; ++rule)
+        score -= m_slot_values[m_rule_slots[rule]];
+
+    return score;
+}
+
+template <typename Value>
+void inf::Marginal::EvaluatorSet::evaluate_outcomes(Index const inflation_party,
+                                                    std::vector<inf::Outcome> const &outcomes,
+                                                    std::vector<Num> &scores) const {
+    ASSERT_TRUE(is_arena_up_to_date())
+
+    Index const first_rule = m_party_first_rule[inflation_party];
+    Index const end_rule = m_party_first_rule[inflation_party + 1];
+    Index const current_outcome = m_inflation_event[inflation_party];
+    Index const n_outcomes = outcomes.size();
+
+    scores.assign(n_outcomes, get_score_without_party(inflation_party));
+
+    Value const *const arena = get_arena<Value>();
+    inf::Marginal::EvaluatorSet::TableIndex const *const arena_indices = m_arena_indices->data();
+    for (Index rule(first_rule); rule < end_rule; ++rule) {
+        inf::Marginal::EvaluatorSet::TableIndex const *const hash_steps = &m_rule_hash_steps[rule * m_n_outcomes];
+        // The hash of the marginal event with the marginal outcome of inflation_party set to zero
+        inf::Marginal::EvaluatorSet::TableIndex const hash_without_party = m_slot_hashes[m_rule_slots[rule]] - hash_steps[current_outcome];
+
+        for (Index i(0); i < n_outcomes; ++i)
+            scores[i] += arena[arena_indices[hash_without_party + hash_steps[outcomes[i]]]];
+    }
+}
+
+template <typename Value, inf::Outcome n_outcomes, inf::Outcome n_known_outcomes>
+void inf::Marginal::EvaluatorSet::evaluate_all_outcomes(Index const inflation_party,
+                                                        std::vector<inf::Outcome> const &outcomes,
+                                                        std::vector<Num> &scores) const {
+    static_assert(n_known_outcomes <= n_outcomes);
+    ASSERT_EQUAL(m_n_outcomes, n_outcomes)
+    ASSERT_EQUAL(m_n_known_outcomes, n_known_outcomes)
+    ASSERT_TRUE(is_arena_up_to_date())
+
+    // The outcomes are distinct known outcomes, so this means that they are all there
+    if (outcomes.size() != n_known_outcomes) {
+        evaluate_outcomes<Value>(inflation_party, outcomes, scores);
+        return;
+    }
+
+    Index const first_rule = m_party_first_rule[inflation_party];
+    Index const end_rule = m_party_first_rule[inflation_party + 1];
+    Index const current_outcome = m_inflation_event[inflation_party];
+
+    Num outcome_scores[n_known_outcomes];
+    Num const score_without_party = get_score_without_party(inflation_party);
+    for (Index outcome(0); outcome < n_known_outcomes; ++outcome)
+        outcome_scores[outcome] = score_without_party;
+
+    Value const *const arena = get_arena<Value>();
+    inf::Marginal::EvaluatorSet::TableIndex const *const arena_indices = m_arena_indices->data();
+    for (Index rule(first_rule); rule < end_rule; ++rule) {
+        inf::Marginal::EvaluatorSet::TableIndex const *const hash_steps = &m_rule_hash_steps[rule * n_outcomes];
+        // The hash of the marginal event with the marginal outcome of inflation_party set to zero
+        inf::Marginal::EvaluatorSet::TableIndex const hash_without_party = m_slot_hashes[m_rule_slots[rule]] - hash_steps[current_outcome];
+
+        for (Index outcome(0); outcome < n_known_outcomes; ++outcome)
+            outcome_scores[outcome] += arena[arena_indices[hash_without_party + hash_steps[outcome]]];
+    }
+
+    scores.resize(n_known_outcomes);
+    for (Index i(0); i < n_known_outcomes; ++i)
+        scores[i] = outcome_scores[outcomes[i]];
+}
+
+template <typename Value, inf::Outcome n_outcomes>
+void inf::Marginal::EvaluatorSet::set_outcome_kernel(Index const inflation_party, inf::Outcome const outcome) {
+    ASSERT_LT(outcome, m_n_outcomes)
+    ASSERT_LT(inflation_party, m_inflation_event.size())
+    ASSERT_TRUE(n_outcomes == 0 or n_outcomes == m_n_outcomes)
+
+    inf::Outcome const old_outcome = m_inflation_event[inflation_party];
+    if (outcome == old_outcome)
+        return;
+
+    Index const stride = n_outcomes == 0 ? m_n_outcomes : n_outcomes;
+    Index const end_rule = m_party_first_rule[inflation_party + 1];
+
+    if (is_arena_up_to_date()) {
+        Value const *const arena = get_arena<Value>();
+        inf::Marginal::EvaluatorSet::TableIndex const *const arena_indices = m_arena_indices->data();
+        for (Index rule(m_party_first_rule[inflation_party]); rule < end_rule; ++rule) {
+            inf::Marginal::EvaluatorSet::TableIndex const *const hash_steps = &m_rule_hash_steps[rule * stride];
+            inf::Marginal::EvaluatorSet::TableIndex const slot = m_rule_slots[rule];
+
+            m_slot_hashes[slot] += hash_steps[outcome] - hash_steps[old_outcome];
+
+            Num const new_value = arena[arena_indices[m_slot_hashes[slot]]];
+            m_running_score += new_value - m_slot_values[slot];
+            m_slot_values[slot] = new_value;
+        }
+    } else {
+        // The slot values will be looked up from scratch at the next evaluation, possibly with another arena width
+        for (Index rule(m_party_first_rule[inflation_party]); rule < end_rule; ++rule) {
+            inf::Marginal::EvaluatorSet::TableIndex const *const hash_steps = &m_rule_hash_steps[rule * stride];
+            m_slot_hashes[m_rule_slots[rule]] += hash_steps[outcome] - hash_steps[old_outcome];
+        }
+    }
+
+    m_inflation_event[inflation_party] = outcome;
 }
 
 // Marginal
@@ -7,6 +7,11 @@ class Marginal;
 }
 #include "dual_vector.h"
 
+// For std::int16_t, std::int32_t and std::uint32_t
+#include <cstdint>
+// For std::shared_ptr
+#include <memory>
+
 /*! \file */
 
 namespace inf {
@@ -51,6 +56,8 @@ class Marginal : public util::Loggable {
         bool operator<(inf::Marginal::Permutation const &other) const;
     };
 
+    class EvaluatorSet;
+
     /*! \brief This class contains minimal data allowing to perform the operations described in inf::Marginal
      * \details The idea is that the inf::Marginal::Evaluator contains "compiled" data from an inf::Marginal,
      * allowing efficient extraction of marginal events from marginal permutations \f$\redpermutedmargs\infmarg\f$
@@ -64,6 +71,9 @@ class Marginal : public util::Loggable {
      * and allows the user to update individual outcomes of the inflation event \f$\infevent\f$, which updates the above set accordingly.
      * This allows the tree-based evaluation of inner products (see inf::TreeOpt) to perform the minimum amount of work
      * at terminal nodes.
+     *
+     * The optimizers do not use the inf::Marginal::Evaluator directly: an inf::Marginal::EvaluatorSet compiles the data of all the
+     * inf::Marginal::Evaluator of an inf::ConstraintSet into flat tables.
      * */
     class Evaluator {
       public:
@@ -113,9 +123,10 @@ class Marginal : public util::Loggable {
         Evaluator &operator=(Evaluator &&) = delete;
 
         /*! \brief This sets the reference \f$F \in \vecset\infmarg\f$ to be evaluated as described in inf::Marginal
-         * \details It is implicitly assumed that \f$F = \altquovecembed\infmarg(\quovec)\f$
-         * for some \f$\quovec \in \quovecspace\infmarg\f$. */
-        void set_dual_vector_reference(inf::EventTensor const *dual_vector);
+         * \details We have \f$F = \altquovecembed\infmarg(\quovec)\f$, where \f$\quovec \in \quovecspace\infmarg\f$ is the quovec
+         * last passed to inf::DualVector::set_from_quovec(). The inf::Marginal::Evaluator also refers to inf::DualVector::get_n_updates(),
+         * inf::DualVector::get_orbit_coeffs() and inf::DualVector::get_event_to_quovec_index() for the inf::Marginal::EvaluatorSet. */
+        void set_dual_vector_reference(inf::DualVector const *dual_vector);
 
         /*! \brief This sets the reference scale \f$\consscale\f$ that will be multiplied to the result of the evaluation described in inf::Marginal
          * \details This scale depends in practice on the target distribution \f$\targetp\f$, which means that it will typically change
@@ -139,6 +150,9 @@ class Marginal : public util::Loggable {
         inf::Event const &get_inflation_event() const;
 
       private:
+        // The inf::Marginal::EvaluatorSet compiles the data below into its own tables
+        friend class inf::Marginal::EvaluatorSet;
+
         /*! \brief It is useful to allow for the case \f$\infmarg = \emptyset\f$, in which case this is `true` */
         bool const m_is_scalar_marginal;
 
@@ -164,30 +178,203 @@ class Marginal : public util::Loggable {
 
         /*! \brief The reference dual vector \f$F\f$ to be evaluated */
         inf::EventTensor const *m_dual_vector;
+        /*! \brief The reference to inf::DualVector::get_n_updates() of the inf::DualVector holding `m_dual_vector` */
+        Index const *m_n_dual_vector_updates;
+        /*! \brief The reference to inf::DualVector::get_orbit_coeffs() of the inf::DualVector holding `m_dual_vector` */
+        inf::Quovec const *m_orbit_coeffs;
+        /*! \brief The reference to inf::DualVector::get_event_to_quovec_index() of the inf::DualVector holding `m_dual_vector` */
+        std::vector<inf::QuovecIndex> const *m_event_to_quovec_index;
 
         /*! \brief The reference multiplicative scale constant \f$\consscale\f$ */
         Num const *m_scale;
     };
 
-    /*! \brief This class is a convenience for storing multiple inf::Marginal::Evaluator and adding up their results */
+    /*! \brief This class adds up the results of several inf::Marginal::Evaluator, which it compiles into flat tables
+     * \details Each marginal event of each inf::Marginal::Evaluator is given a *slot*, and the tables are stored as structures of arrays:
+     * - `m_slot_hashes` holds the hash of the marginal event of each slot, offset so as to index `m_arena_indices`,
+     * - the arena holds the orbit coefficients of the dual vector \f$F\f$ of each inf::Marginal::Evaluator (see inf::DualVector::get_orbit_coeffs()),
+     *   already multiplied by its scale \f$\consscale\f$, and `m_arena_indices` maps the hash of each marginal event to the index of its orbit in the arena,
+     * - the update rules of the inflation party `p` are those with indices `m_party_first_rule[p]` to `m_party_first_rule[p+1]-1`:
+     *   each one changes the slot `m_rule_slots[rule]`, whose hash changes by
+     *   `m_rule_hash_steps[rule * m_n_outcomes + new_outcome] - m_rule_hash_steps[rule * m_n_outcomes + old_outcome]`.
+     *
+     * On top of this, the inf::Marginal::EvaluatorSet keeps the value of each slot and their sum, the running score.
+     * Changing the outcome of an inflation party only updates the slots of the marginal events involving that party,
+     * so that inf::Marginal::EvaluatorSet::evaluate_dual_vector() does not look up any marginal event.
+     * Going back up the tree is done by setting the outcomes to unknown again, which costs the same as undoing the changes.
+     *
+     * The arena is copied again, and the running score summed again from scratch, whenever a dual vector or a scale changed,
+     * see inf::DualVector::get_n_updates(). This only copies one value per orbit rather than one value per marginal event.
+     * Each copy of the inf::Marginal::EvaluatorSet, e.g., each thread of inf::TreeOpt, has its own arena, but they all share `m_arena_indices`,
+     * which does not depend on the dual vectors.
+     * The arena is stored with the narrowest integer type that holds all of its values, see inf::Marginal::EvaluatorSet::ArenaWidth,
+     * while the slot values and the scores are always accumulated as ::Num. The bound inf::ConstraintSet::get_max_dual_vector_component()
+     * ensures that these sums do not overflow.
+     *
+     * The tables are indexed with inf::Marginal::EvaluatorSet::TableIndex rather than ::Index, which halves their size.
+     * For the numbers of outcomes that are most common in practice, inf::Marginal::EvaluatorSet::evaluate_dual_vector_for_outcomes()
+     * and inf::Marginal::EvaluatorSet::set_outcome() run kernels in which the number of outcomes is a compile-time constant,
+     * see inf::Marginal::EvaluatorSet::evaluate_all_outcomes(). They are selected in the constructor, and again whenever the arena changes width. */
     class EvaluatorSet {
       public:
-        /*! \brief Initialization with a list of inf::Marginal::Evaluator */
-        EvaluatorSet(std::vector<Evaluator> const &evaluators);
+        /*! \brief The integer type of the hashes, hash steps and slots of the tables */
+        typedef std::uint32_t TableIndex;
+
+        /*! \brief The integer type of the values of the arena */
+        enum class ArenaWidth {
+            int16, ///< `std::int16_t`
+            int32, ///< `std::int32_t`
+            int64  ///< ::Num
+        };
 
-        /*! \brief This evaluates each internal inf::Marginal::Evaluator and returns the sum of their results */
-        Num evaluate_dual_vector() const;
+        /*! \brief Compiles a list of inf::Marginal::Evaluator, which must all have their dual vector and scale references set
+         * and share the same inflation event
+         * \param evaluators The inf::Marginal::Evaluator to compile
+         * \param store_bounds Whether the dual vectors of \p evaluators store bounds, i.e., whether their number of outcomes includes the unknown outcome */
+        EvaluatorSet(std::vector<Evaluator> const &evaluators, inf::DualVector::StoreBounds store_bounds);
 
-        /*! \brief This sets the outcome of the specified inflation party for each internal inf::Marginal::Evaluator
-         * \sa inf::Marginal::set_outcome() */
-        void set_outcome(Index const inflation_party, inf::Outcome const outcome);
+        /*! \brief Returns the sum of the results of inf::Marginal::Evaluator::evaluate_dual_vector() over the compiled inf::Marginal::Evaluator */
+        Num evaluate_dual_vector() const;
 
-        /*! \brief All internal inf::Marginal::Evaluator store the same underlying inflation event \f$\infevent\f$ which is returned here */
+        /*! \brief Sets `scores[i]` to what inf::Marginal::EvaluatorSet::evaluate_dual_vector() would return if the outcome of \p inflation_party was `outcomes[i]`
+         * \details The underlying inflation event is left unchanged. Only the slots involving \p inflation_party depend on its outcome:
+         * their values are removed from the running score once, and looked up in the arena for each outcome.
+         * \param inflation_party The inflation party whose outcome varies
+         * \param outcomes The outcomes of \p inflation_party to evaluate, which must be distinct and different from the unknown outcome
+         * \param scores This is resized to the size of \p outcomes */
+        void evaluate_dual_vector_for_outcomes(Index const inflation_party,
+                                               std::vector<inf::Outcome> const &outcomes,
+                                               std::vector<Num> &scores) const {
+            // The arena may change width, and thus the kernel
+            if (not is_arena_up_to_date())
+                update_arena();
+            (this->*m_outcomes_kernel)(inflation_party, outcomes, scores);
+        }
+
+        /*! \brief This sets the outcome of the specified inflation party
+         * \sa inf::Marginal::Evaluator::set_outcome() */
+        void set_outcome(Index const inflation_party, inf::Outcome const outcome) {
+            (this->*m_set_outcome_kernel)(inflation_party, outcome);
+        }
+
+        /*! \brief Returns the underlying inflation event \f$\infevent\f$ */
         inf::Event const &get_inflation_event() const;
 
+        /*! \brief Returns the integer type with which the arena is currently stored
+         * \details This is only known once the arena was filled, i.e., after a first evaluation. */
+        inf::Marginal::EvaluatorSet::ArenaWidth get_arena_width() const;
+
       private:
-        /*! \brief The list of inf::Marginal::Evaluator */
-        std::vector<Evaluator> m_evaluators;
+        /*! \brief Where the values of a segment of the arena come from */
+        struct Source {
+            /*! \brief The orbit coefficients of the dual vector \f$F\f$ of an inf::Marginal::Evaluator, see inf::DualVector::get_orbit_coeffs() */
+            inf::Quovec const *orbit_coeffs;
+            /*! \brief See inf::DualVector::get_n_updates() */
+            Index const *n_dual_vector_updates;
+            /*! \brief The scale \f$\consscale\f$ of the inf::Marginal::Evaluator */
+            Num const *scale;
+            /*! \brief Where the copy of `orbit_coeffs` starts in the arena */
+            Index arena_offset;
+            /*! \brief The value of `*n_dual_vector_updates` when the segment was copied */
+            Index n_updates_seen;
+            /*! \brief The value of `*scale` when the segment was copied */
+            Num scale_seen;
+        };
+
+        /*! \brief The type of the kernels of inf::Marginal::EvaluatorSet::evaluate_dual_vector_for_outcomes() */
+        typedef void (inf::Marginal::EvaluatorSet::*OutcomesKernel)(Index const, std::vector<inf::Outcome> const &, std::vector<Num> &) const;
+        /*! \brief The type of the kernels of inf::Marginal::EvaluatorSet::set_outcome() */
+        typedef void (inf::Marginal::EvaluatorSet::*SetOutcomeKernel)(Index const, inf::Outcome const);
+
+        /*! \brief The underlying inflation event \f$\infevent\f$ */
+        inf::Event m_inflation_event;
+        /*! \brief The number of outcomes per inflation party, including the unknown outcome if the dual vectors store bounds */
+        inf::Outcome m_n_outcomes;
+        /*! \brief The number of outcomes per inflation party, excluding the unknown outcome */
+        inf::Outcome m_n_known_outcomes;
+
+        /*! \brief The update rules of the inflation party `p` are those from `m_party_first_rule[p]` to `m_party_first_rule[p+1]` (excluded) */
+        std::vector<Index> m_party_first_rule;
+        /*! \brief The slot that each update rule changes */
+        std::vector<inf::Marginal::EvaluatorSet::TableIndex> m_rule_slots;
+        /*! \brief `m_rule_hash_steps[rule * m_n_outcomes + outcome]` is the contribution of the inflation party to the hash of the slot when it has outcome `outcome`
+         * \details This is the image of `outcome` by the inverse outcome symmetry of the update rule, times the weight of the marginal party,
+         * see inf::Marginal::Evaluator::UpdateRule. */
+        std::vector<inf::Marginal::EvaluatorSet::TableIndex> m_rule_hash_steps;
+        /*! \brief The hash of the marginal event of each slot, as an index of `m_arena_indices` */
+        std::vector<inf::Marginal::EvaluatorSet::TableIndex> m_slot_hashes;
+        /*! \brief `(*m_arena_indices)[hash]` is the index in the arena of the orbit of the marginal event with hash `hash`
+         * \details The marginal events of the inf::Marginal::Evaluator are hashed as in inf::Marginal::Evaluator, plus an offset per inf::Marginal::Evaluator.
+         * This is shared by the copies of the inf::Marginal::EvaluatorSet. */
+        std::shared_ptr<std::vector<inf::Marginal::EvaluatorSet::TableIndex> const> m_arena_indices;
+        /*! \brief The number of values of the arena, i.e., the total number of orbits */
+        Index m_arena_size;
+
+        // The members below only depend on the dual vectors and scales, they are refreshed in inf::Marginal::EvaluatorSet::update_arena(),
+        // which is why they are `mutable`
+
+        /*! \brief The kernel run by inf::Marginal::EvaluatorSet::evaluate_dual_vector_for_outcomes() */
+        mutable inf::Marginal::EvaluatorSet::OutcomesKernel m_outcomes_kernel;
+        /*! \brief The kernel run by inf::Marginal::EvaluatorSet::set_outcome() */
+        mutable inf::Marginal::EvaluatorSet::SetOutcomeKernel m_set_outcome_kernel;
+        /*! \brief The origin of each segment of the arena, one per compiled inf::Marginal::Evaluator */
+        mutable std::vector<inf::Marginal::EvaluatorSet::Source> m_sources;
+        /*! \brief Which of the vectors below holds the arena, the other ones being empty */
+        mutable inf::Marginal::EvaluatorSet::ArenaWidth m_arena_width;
+        /*! \brief The arena, i.e., the orbit coefficients of all the compiled inf::Marginal::Evaluator, multiplied by their scales, one after the other,
+         * if `m_arena_width == inf::Marginal::EvaluatorSet::ArenaWidth::int16` */
+        mutable std::vector<std::int16_t> m_dual_vector_arena_16;
+        /*! \brief The arena if `m_arena_width == inf::Marginal::EvaluatorSet::ArenaWidth::int32` */
+        mutable std::vector<std::int32_t> m_dual_vector_arena_32;
+        /*! \brief The arena if `m_arena_width == inf::Marginal::EvaluatorSet::ArenaWidth::int64` */
+        mutable std::vector<Num> m_dual_vector_arena_64;
+        /*! \brief `m_slot_values[slot]` is the value of the arena at `(*m_arena_indices)[m_slot_hashes[slot]]` */
+        mutable std::vector<Num> m_slot_values;
+        /*! \brief The sum of `m_slot_values` */
+        mutable Num m_running_score;
+
+        /*! \brief Returns `true` if no dual vector nor scale changed since the last call to inf::Marginal::EvaluatorSet::update_arena() */
+        bool is_arena_up_to_date() const;
+        /*! \brief Copies the orbit coefficients to the arena, with the narrowest sufficient inf::Marginal::EvaluatorSet::ArenaWidth,
+         * and computes `m_slot_values` and `m_running_score` from scratch */
+        void update_arena() const;
+        /*! \brief Copies the orbit coefficients to \p arena, which is first resized, and computes `m_slot_values` and `m_running_score` from scratch */
+        template <typename Value>
+        void fill_arena(std::vector<Value> &arena) const;
+        /*! \brief Returns the arena stored with the type \p Value */
+        template <typename Value>
+        Value const *get_arena() const;
+
+        /*! \brief Sets `m_outcomes_kernel` and `m_set_outcome_kernel` to the kernels compiled for `m_arena_width`, `m_n_outcomes` and `m_n_known_outcomes`, if any */
+        void select_kernels() const;
+        /*! \brief Same as inf::Marginal::EvaluatorSet::select_kernels() for the arena type \p Value */
+        template <typename Value>
+        void select_kernels_for() const;
+
+        /*! \brief Returns the sum of `m_slot_values` over the slots that do not involve \p inflation_party */
+        Num get_score_without_party(Index const inflation_party) const;
+
+        /*! \brief The generic kernel of inf::Marginal::EvaluatorSet::evaluate_dual_vector_for_outcomes()
+         * \details For each update rule of the inflation party, this looks up the arena once per element of \p outcomes.
+         * The kernels of inf::Marginal::EvaluatorSet::evaluate_dual_vector_for_outcomes() expect the arena to be up to date. */
+        template <typename Value>
+        void evaluate_outcomes(Index const inflation_party,
+                               std::vector<inf::Outcome> const &outcomes,
+                               std::vector<Num> &scores) const;
+        /*! \brief The kernel of inf::Marginal::EvaluatorSet::evaluate_dual_vector_for_outcomes() for the arena type \p Value, `m_n_outcomes == n_outcomes`
+         * and `m_n_known_outcomes == n_known_outcomes`
+         * \details If \p outcomes contains every known outcome, which is the case in the lower bounds of inf::TreeOpt and at most of its last nodes,
+         * the scores of all the known outcomes are accumulated in a local array whose loops the compiler unrolls, and then permuted into \p scores.
+         * Otherwise, this falls back to inf::Marginal::EvaluatorSet::evaluate_outcomes(). */
+        template <typename Value, inf::Outcome n_outcomes, inf::Outcome n_known_outcomes>
+        void evaluate_all_outcomes(Index const inflation_party,
+                                   std::vector<inf::Outcome> const &outcomes,
+                                   std::vector<Num> &scores) const;
+
+        /*! \brief The kernel of inf::Marginal::EvaluatorSet::set_outcome() for the arena type \p Value and `m_n_outcomes == n_outcomes`,
+         * or for any `m_n_outcomes` if \p n_outcomes is `0` */
+        template <typename Value, inf::Outcome n_outcomes>
+        void set_outcome_kernel(Index const inflation_party, inf::Outcome const outcome);
     };
 
     /*! \brief Initialize with an inf::Inflation and a set of inflation party \f$\infmarg\subset\infparties\f$ essentially
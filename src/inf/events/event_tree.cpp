@@ -2,7 +2,12 @@
 
 #include "../../util/debug.h"
 #include "../../util/logger.h"
+#include "../../util/math.h"
 #include "../../util/misc.h"
+// For std::memcpy
+#include <cstring>
+#include <fstream>
+#include <limits>
 
 inf::EventTree::NodePos::NodePos(Index const depth, Index const node_index)
     : depth(depth), node_index(node_index) {}
@@ -130,9 +135,16 @@ void inf::EventTree::Node::io(util::FileStream &stream) {
 
 // Tree
 
+// "INFTREE" followed by the version of the frozen layout, read as a little-endian integer
+Index const inf::EventTree::image_magic = 0x0145455254464e49;
+Index const inf::EventTree::image_version = 1;
+std::string const inf::EventTree::image_extension = ".image";
+
 inf::EventTree::EventTree(Index const depth)
-    : m_depth(depth), m_node_cache(depth), m_finished_initialization(false),
-      m_memory_footprint(0), m_n_leaves(0), m_n_nodes_total(0) {
+    : m_depth(depth), m_node_cache(depth), m_node_index(depth),
+      m_frozen{}, m_frozen_data(nullptr), m_frozen_data_size(0), m_frozen_storage{}, m_mapped_file(nullptr),
+      m_finished_initialization(false),
+      m_memory_footprint(0), m_n_leaves(0), m_n_nodes_total(0), m_breadths{}, m_n_leaves_from{} {
     ASSERT_LT(0, depth)
     // This doesn't seem to help...
     // m_node_cache.reserve(91418);
@@ -144,18 +156,19 @@ void inf::EventTree::log_flat() const {
     LOG_BEGIN_SECTION("inf::EventTree (flat)")
 
     for (Index depth : util::Range(m_depth)) {
-        for (Index node_index : util::Range(m_node_cache[depth].size())) {
+        inf::EventTree::FrozenDepth const &frozen_depth = m_frozen[depth];
+
+        for (Index node_index : util::Range(frozen_depth.n_nodes)) {
 
-            inf::EventTree::Node const &the_node = m_node_cache[depth][node_index];
             util::logger << "N[" << depth << "," << node_index << "] : ";
             util::logger.echo_colored_number(
-                static_cast<int>(the_node.outcome));
+                static_cast<int>(frozen_depth.outcomes[node_index]));
             util::logger << " -> (";
-            for (Index child_i : util::Range(the_node.n_children)) {
-                if (child_i > 0)
+            for (Index child_i : util::Range(frozen_depth.child_offsets[node_index], frozen_depth.child_offsets[node_index + 1])) {
+                if (child_i > frozen_depth.child_offsets[node_index])
                     util::logger << ", ";
                 util::logger << "N[" << depth + 1 << ","
-                             << the_node.children[child_i] << "]";
+                             << frozen_depth.children[child_i] << "]";
             }
             util::logger << ")" << util::cr;
         }
@@ -170,7 +183,7 @@ void inf::EventTree::log() const {
     LOG_BEGIN_SECTION("inf::EventTree")
 
     util::logger << util::begin_section;
-    for (Index root_child_i : util::Range(m_node_cache[0].size())) {
+    for (Index root_child_i : util::Range(get_root_children_count())) {
         this->log_node_recursive(0, root_child_i);
     }
     util::logger << util::end_section;
@@ -201,7 +214,7 @@ void inf::EventTree::log_info() const {
         for (Index depth : util::Range(m_depth)) {
             util::logger << util::begin_comment << "Depth " << util::end_comment
                          << depth << util::begin_comment << ": "
-                         << util::end_comment << m_node_cache[depth].size()
+                         << util::end_comment << m_frozen[depth].n_nodes
                          << util::begin_comment << " cached nodes"
                          << util::end_comment << util::cr;
         }
@@ -214,13 +227,14 @@ void inf::EventTree::log_node_recursive(Index const depth,
                                         Index const node_index) const {
     ASSERT_LT(depth, m_depth)
 
-    inf::EventTree::Node const &the_node = m_node_cache[depth][node_index];
-    util::logger.echo_colored_number(static_cast<int>(the_node.outcome));
+    inf::EventTree::FrozenDepth const &frozen_depth = m_frozen[depth];
+
+    util::logger.echo_colored_number(static_cast<int>(frozen_depth.outcomes[node_index]));
     util::logger << util::cr;
-    if (the_node.n_children != 0) {
+    if (frozen_depth.child_offsets[node_index] != frozen_depth.child_offsets[node_index + 1]) {
         util::logger << util::begin_section;
-        for (Index child_i : util::Range(the_node.n_children)) {
-            this->log_node_recursive(depth + 1, the_node.children[child_i]);
+        for (Index child_i : util::Range(frozen_depth.child_offsets[node_index], frozen_depth.child_offsets[node_index + 1])) {
+            this->log_node_recursive(depth + 1, frozen_depth.children[child_i]);
         }
         util::logger << util::end_section;
     }
@@ -237,15 +251,18 @@ Index inf::EventTree::insert_node(Index const depth, inf::Outcome const outcome,
     // LOG_VARIABLE(children_vec)
 
     std::vector<inf::EventTree::Node> &current_node_cache = m_node_cache[depth];
+    std::unordered_multimap<std::size_t, Index> &current_node_index = m_node_index[depth];
     Index const node_cache_size = current_node_cache.size();
     inf::Outcome const children_vec_size = static_cast<inf::Outcome>(children_vec.size());
+    std::size_t const node_hash = hash_node(outcome, children_vec);
     // For performance
     bool equal;
     inf::Outcome node_i;
 
-    for (Index pos(0); pos < node_cache_size; ++pos) {
-        // Seems slightly more efficient to remove this?
-        // inf::EventTree::Node const& node = current_node_cache[pos];
+    // Only the cached nodes sharing the hash of the new node can be equal to it
+    auto const [candidates_begin, candidates_end] = current_node_index.equal_range(node_hash);
+    for (auto candidate = candidates_begin; candidate != candidates_end; ++candidate) {
+        Index const pos = candidate->second;
 
         if (current_node_cache[pos].outcome == outcome and
             current_node_cache[pos].n_children == children_vec_size) {
@@ -270,82 +287,360 @@ Index inf::EventTree::insert_node(Index const depth, inf::Outcome const outcome,
 
     // If we didn't find the node, we create a new one
     current_node_cache.emplace_back(outcome, children_vec);
+    current_node_index.emplace(node_hash, node_cache_size);
     return node_cache_size; // or current_node_cache.size() - 1
 }
 
-void inf::EventTree::finish_initialization() {
+std::vector<std::vector<Index>> inf::EventTree::merge_nodes(inf::EventTree const &other) {
     ASSERT_TRUE(not m_finished_initialization)
+    ASSERT_TRUE(not other.m_finished_initialization)
+    HARD_ASSERT_EQUAL(m_depth, other.m_depth)
 
-    m_node_cache.shrink_to_fit();
-    for (std::vector<inf::EventTree::Node> &node_cache : m_node_cache) {
-        node_cache.shrink_to_fit();
-    }
+    std::vector<std::vector<Index>> node_indices(m_depth);
+    std::vector<Index> children_vec;
 
-    init_info();
+    // Bottom-up, so that the children of a node of other are already mapped when we insert it
+    for (Index depth = m_depth; depth-- > 0;) {
+        node_indices[depth].reserve(other.m_node_cache[depth].size());
 
-    m_finished_initialization = true;
-}
+        for (inf::EventTree::Node const &node : other.m_node_cache[depth]) {
+            children_vec.resize(node.n_children);
+            for (Index child_i : util::Range(node.n_children))
+                children_vec[child_i] = node_indices[depth + 1][node.children[child_i]];
 
-Index inf::EventTree::get_memory_footprint() const {
-    return m_memory_footprint;
+            node_indices[depth].push_back(insert_node(depth, node.outcome, children_vec));
+        }
+    }
+
+    return node_indices;
 }
 
-Index inf::EventTree::get_depth() const { return m_depth; }
+void inf::EventTree::io_nodes(util::FileStream &stream) {
+    HARD_ASSERT_TRUE(not m_finished_initialization)
 
-Index inf::EventTree::get_n_leaves() const { return m_n_leaves; }
+    if (stream.is_reading()) {
+        for (std::vector<inf::EventTree::Node> const &node_cache_row : m_node_cache)
+            HARD_ASSERT_EQUAL(node_cache_row.size(), 0)
+    }
 
-Index inf::EventTree::get_n_nodes_cached() const {
-    Index ret = 0;
-    for (std::vector<inf::EventTree::Node> const &node_cache : m_node_cache) {
-        ret += node_cache.size();
+    stream.io(m_node_cache);
+
+    if (stream.is_reading()) {
+        HARD_ASSERT_EQUAL(m_depth, m_node_cache.size())
+
+        // The hash index is needed to insert further nodes
+        std::vector<Index> children_vec;
+        for (Index depth : util::Range(m_depth)) {
+            m_node_index[depth].clear();
+
+            for (Index node_index : util::Range(m_node_cache[depth].size())) {
+                inf::EventTree::Node const &node = m_node_cache[depth][node_index];
+
+                children_vec.assign(node.children, node.children + node.n_children);
+                if (depth == m_depth - 1) {
+                    HARD_ASSERT_EQUAL(node.n_children, 0)
+                } else {
+                    for (Index const child : children_vec)
+                        HARD_ASSERT_LT(child, m_node_cache[depth + 1].size())
+                }
+
+                m_node_index[depth].emplace(hash_node(node.outcome, children_vec), node_index);
+            }
+        }
     }
+}
+
+std::size_t inf::EventTree::hash_node(inf::Outcome const outcome, std::vector<Index> const &children_vec) {
+    // Same mixing as boost::hash_combine
+    std::size_t ret = std::hash<inf::Outcome>{}(outcome);
+    for (Index const child : children_vec)
+        ret ^= std::hash<Index>{}(child) + 0x9e3779b97f4a7c15 + (ret << 6) + (ret >> 2);
     return ret;
 }
 
-Index inf::EventTree::get_n_nodes_total() const { return m_n_nodes_total; }
+void inf::EventTree::finish_initialization() {
+    ASSERT_TRUE(not m_finished_initialization)
 
-Index inf::EventTree::get_breadth_at_depth(Index const depth) const {
-    ASSERT_LT(depth, get_depth())
+    // The hash index is only needed to insert nodes
+    m_node_index.clear();
+    m_node_index.shrink_to_fit();
 
-    Index breadth = 0;
+    freeze();
 
-    inf::EventTree::NodePos::Queue queue = get_root_children_queue();
+    m_finished_initialization = true;
+
+    init_info();
+}
+
+void inf::EventTree::freeze() {
+    HARD_ASSERT_EQUAL(m_node_cache.size(), m_depth)
+
+    Index const no_index = std::numeric_limits<Index>::max();
+
+    // new_indices[depth][i] is the index in the frozen layout of the node m_node_cache[depth][i]
+    std::vector<std::vector<Index>> new_indices(m_depth);
+    // old_indices[depth][j] is the index in m_node_cache[depth] of the node j of the frozen layout
+    std::vector<std::vector<Index>> old_indices(m_depth);
+    for (Index const depth : util::Range(m_depth))
+        new_indices[depth] = std::vector<Index>(m_node_cache[depth].size(), no_index);
+
+    // Depth-first traversal that numbers the nodes in the order in which they are first visited.
+    // The children are pushed in reverse order so that they are visited in order.
+    inf::EventTree::NodePos::Queue queue;
+    for (Index const root_i : util::Range(m_node_cache[0].size()))
+        queue.emplace_back(0, m_node_cache[0].size() - 1 - root_i);
 
     while (not queue.empty()) {
-        inf::EventTree::NodePos node_pos = util::pop_back(queue);
+        inf::EventTree::NodePos const node_pos = util::pop_back(queue);
+        Index &new_index = new_indices[node_pos.depth][node_pos.node_index];
+
+        // Already visited through another parent, in which case its descendants are numbered too
+        if (new_index != no_index)
+            continue;
+
+        new_index = old_indices[node_pos.depth].size();
+        old_indices[node_pos.depth].push_back(node_pos.node_index);
+
+        inf::EventTree::Node const &the_node = m_node_cache[node_pos.depth][node_pos.node_index];
+        for (Index const child_i : util::Range(the_node.n_children))
+            queue.emplace_back(node_pos.depth + 1, the_node.children[the_node.n_children - 1 - child_i]);
+    }
+
+    // Sizes of the frozen layout, see m_frozen_data
+    std::vector<Index> n_children_total(m_depth, 0);
+    Index frozen_data_size = (1 + 2 * m_depth) * sizeof(Index);
+    for (Index const depth : util::Range(m_depth)) {
+        Index const n_nodes = old_indices[depth].size();
+
+        for (Index const old_index : old_indices[depth])
+            n_children_total[depth] += m_node_cache[depth][old_index].n_children;
+
+        HARD_ASSERT_LT(n_nodes, std::numeric_limits<inf::EventTree::CompactIndex>::max())
+        HARD_ASSERT_LT(n_children_total[depth], std::numeric_limits<inf::EventTree::CompactIndex>::max())
+
+        frozen_data_size += util::round_up(n_nodes * sizeof(inf::Outcome), sizeof(Index)) +
+                            util::round_up((n_nodes + 1 + n_children_total[depth]) * sizeof(inf::EventTree::CompactIndex), sizeof(Index));
+    }
+
+    m_frozen_storage = std::vector<char>(frozen_data_size, 0);
+    char *const frozen_data = m_frozen_storage.data();
+    Index *const header = reinterpret_cast<Index *>(frozen_data);
+
+    header[0] = m_depth;
+    Index position = (1 + 2 * m_depth) * sizeof(Index);
 
-        if (node_pos.depth == depth) {
-            ++breadth;
-        } else if (node_pos.depth < depth) {
-            add_children_to_queue(queue, node_pos);
+    for (Index const depth : util::Range(m_depth)) {
+        Index const n_nodes = old_indices[depth].size();
+        header[1 + 2 * depth] = n_nodes;
+        header[2 + 2 * depth] = n_children_total[depth];
+
+        inf::Outcome *const outcomes = reinterpret_cast<inf::Outcome *>(frozen_data + position);
+        position += util::round_up(n_nodes * sizeof(inf::Outcome), sizeof(Index));
+
+        inf::EventTree::CompactIndex *const child_offsets = reinterpret_cast<inf::EventTree::CompactIndex *>(frozen_data + position);
+        inf::EventTree::CompactIndex *const children = child_offsets + n_nodes + 1;
+        position += util::round_up((n_nodes + 1 + n_children_total[depth]) * sizeof(inf::EventTree::CompactIndex), sizeof(Index));
+
+        Index n_children = 0;
+        child_offsets[0] = 0;
+        for (Index const node_index : util::Range(n_nodes)) {
+            inf::EventTree::Node const &the_node = m_node_cache[depth][old_indices[depth][node_index]];
+
+            outcomes[node_index] = the_node.outcome;
+            for (Index const child_i : util::Range(the_node.n_children)) {
+                children[n_children] = static_cast<inf::EventTree::CompactIndex>(new_indices[depth + 1][the_node.children[child_i]]);
+                ++n_children;
+            }
+            child_offsets[node_index + 1] = static_cast<inf::EventTree::CompactIndex>(n_children);
         }
     }
 
-    return breadth;
+    ASSERT_EQUAL(position, frozen_data_size)
+    set_frozen_data(frozen_data, frozen_data_size);
+
+    // The root children keep their numbering
+    ASSERT_EQUAL(m_frozen[0].n_nodes, m_node_cache[0].size())
+
+    m_node_cache.clear();
+    m_node_cache.shrink_to_fit();
 }
 
-Index inf::EventTree::count_leaves_from(inf::EventTree::NodePos const &initial_node_pos) const {
+std::vector<std::vector<inf::EventTree::Node>> inf::EventTree::get_node_cache() const {
+    std::vector<std::vector<inf::EventTree::Node>> node_cache(m_depth);
 
-    Index ret = 0;
+    for (Index const depth : util::Range(m_depth)) {
+        inf::EventTree::FrozenDepth const &frozen_depth = m_frozen[depth];
+        node_cache[depth].reserve(frozen_depth.n_nodes);
+
+        for (Index const node_index : util::Range(frozen_depth.n_nodes)) {
+            std::vector<Index> children_vec;
+            for (Index child_i : util::Range(frozen_depth.child_offsets[node_index], frozen_depth.child_offsets[node_index + 1]))
+                children_vec.push_back(frozen_depth.children[child_i]);
+
+            node_cache[depth].emplace_back(frozen_depth.outcomes[node_index], children_vec);
+        }
+    }
 
-    inf::EventTree::NodePos::Queue queue{initial_node_pos};
+    return node_cache;
+}
 
-    // Our below logic assumes at least depth 2
-    ASSERT_LT(1, get_depth())
+void inf::EventTree::set_frozen_data(char const *const frozen_data, Index const frozen_data_size) {
+    // The arrays are read in place, so they need to be suitably aligned
+    HARD_ASSERT_EQUAL(reinterpret_cast<std::uintptr_t>(frozen_data) % alignof(Index), 0)
+    HARD_ASSERT_LTE((1 + 2 * m_depth) * sizeof(Index), frozen_data_size)
 
-    while (not queue.empty()) {
-        inf::EventTree::NodePos node_pos = util::pop_back(queue);
+    Index const *const header = reinterpret_cast<Index const *>(frozen_data);
+    HARD_ASSERT_EQUAL(header[0], m_depth)
+
+    m_frozen = std::vector<inf::EventTree::FrozenDepth>(m_depth);
+    Index position = (1 + 2 * m_depth) * sizeof(Index);
 
-        // If at forelast depth
-        if (node_pos.depth == get_depth() - 1)
-            ret += 1;
-        else
-            add_children_to_queue(queue, node_pos);
+    for (Index const depth : util::Range(m_depth)) {
+        inf::EventTree::FrozenDepth &frozen_depth = m_frozen[depth];
+        Index const n_nodes = header[1 + 2 * depth];
+        Index const n_children = header[2 + 2 * depth];
+
+        HARD_ASSERT_LT(0, n_nodes)
+        HARD_ASSERT_LT(n_nodes, std::numeric_limits<inf::EventTree::CompactIndex>::max())
+        HARD_ASSERT_LT(n_children, std::numeric_limits<inf::EventTree::CompactIndex>::max())
+
+        Index const outcomes_size = util::round_up(n_nodes * sizeof(inf::Outcome), sizeof(Index));
+        Index const indices_size = util::round_up((n_nodes + 1 + n_children) * sizeof(inf::EventTree::CompactIndex), sizeof(Index));
+        HARD_ASSERT_LTE(position + outcomes_size + indices_size, frozen_data_size)
+
+        frozen_depth.n_nodes = n_nodes;
+        frozen_depth.outcomes = reinterpret_cast<inf::Outcome const *>(frozen_data + position);
+        frozen_depth.child_offsets = reinterpret_cast<inf::EventTree::CompactIndex const *>(frozen_data + position + outcomes_size);
+        frozen_depth.children = frozen_depth.child_offsets + n_nodes + 1;
+        position += outcomes_size + indices_size;
+
+        // The offsets should be increasing and consistent with the number of children
+        HARD_ASSERT_EQUAL(frozen_depth.child_offsets[0], 0)
+        for (Index const node_index : util::Range(n_nodes))
+            HARD_ASSERT_LTE(frozen_depth.child_offsets[node_index], frozen_depth.child_offsets[node_index + 1])
+        HARD_ASSERT_EQUAL(frozen_depth.child_offsets[n_nodes], n_children)
+
+        // We expect childless nodes at the last depth
+        if (depth == m_depth - 1)
+            HARD_ASSERT_EQUAL(n_children, 0)
     }
 
+    HARD_ASSERT_EQUAL(position, frozen_data_size)
+
+    // Now that all the depths are known, we can check that the child indices make sense
+    for (Index const depth : util::Range(m_depth - 1)) {
+        inf::EventTree::FrozenDepth const &frozen_depth = m_frozen[depth];
+        Index const next_n_nodes = m_frozen[depth + 1].n_nodes;
+
+        for (Index const child_i : util::Range(frozen_depth.child_offsets[frozen_depth.n_nodes]))
+            HARD_ASSERT_LT(frozen_depth.children[child_i], next_n_nodes)
+    }
+
+    m_frozen_data = frozen_data;
+    m_frozen_data_size = frozen_data_size;
+}
+
+void inf::EventTree::write_image(std::string const &filename, std::string const &metadata) const {
+    HARD_ASSERT_TRUE(is_initialized())
+
+    std::ofstream out_stream(filename + image_extension, std::ios_base::out | std::ios_base::binary);
+    if (not out_stream.is_open())
+        THROW_ERROR("Could not open the file " + filename + image_extension)
+
+    // Header: the metadata is padded so that the frozen layout remains aligned in the file
+    Index const metadata_size = metadata.size();
+    Index const header[3] = {image_magic, image_version, metadata_size};
+    out_stream.write(reinterpret_cast<char const *>(header), sizeof(header));
+    out_stream.write(metadata.data(), static_cast<std::streamsize>(metadata_size));
+    std::string const padding(util::round_up(metadata_size, sizeof(Index)) - metadata_size, '\0');
+    out_stream.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+    // Frozen layout
+    out_stream.write(m_frozen_data, static_cast<std::streamsize>(m_frozen_data_size));
+
+    HARD_ASSERT_TRUE(out_stream.good())
+
+    util::logger << "Writing to file " << filename << image_extension
+                 << "." << util::cr << "Metadata: "
+                 << metadata << util::cr;
+}
+
+void inf::EventTree::read_image(std::string const &filename, std::string const &expected_metadata) {
+    HARD_ASSERT_TRUE(not is_initialized())
+
+    m_mapped_file = std::make_unique<util::MappedFile>(filename + image_extension);
+    char const *const image = m_mapped_file->get_data();
+    Index const image_size = m_mapped_file->get_size();
+
+    // Header
+    Index const header_size = 3 * sizeof(Index);
+    HARD_ASSERT_LTE(header_size, image_size)
+    Index const *const header = reinterpret_cast<Index const *>(image);
+    HARD_ASSERT_EQUAL(header[0], image_magic)
+    HARD_ASSERT_EQUAL(header[1], image_version)
+
+    Index const metadata_size = header[2];
+    HARD_ASSERT_LTE(header_size + metadata_size, image_size)
+    std::string const metadata_read(image + header_size, metadata_size);
+    HARD_ASSERT_EQUAL(metadata_read, expected_metadata)
+
+    util::logger << "Reading file " << filename << image_extension
+                 << "." << util::cr << "Metadata: "
+                 << metadata_read << util::cr;
+
+    // Frozen layout, used in place
+    Index const frozen_data_position = header_size + util::round_up(metadata_size, sizeof(Index));
+    HARD_ASSERT_LT(frozen_data_position, image_size)
+    set_frozen_data(image + frozen_data_position, image_size - frozen_data_position);
+
+    // Nothing will be inserted in this inf::EventTree
+    m_node_cache.clear();
+    m_node_cache.shrink_to_fit();
+    m_node_index.clear();
+    m_node_index.shrink_to_fit();
+
+    m_finished_initialization = true;
+
+    init_info();
+}
+
+bool inf::EventTree::image_exists(std::string const &filename) {
+    return util::MappedFile::exists(filename + image_extension);
+}
+
+Index inf::EventTree::get_memory_footprint() const {
+    return m_memory_footprint;
+}
+
+Index inf::EventTree::get_depth() const { return m_depth; }
+
+Index inf::EventTree::get_n_leaves() const { return m_n_leaves; }
+
+Index inf::EventTree::get_n_nodes_cached() const {
+    Index ret = 0;
+    for (inf::EventTree::FrozenDepth const &frozen_depth : m_frozen) {
+        ret += frozen_depth.n_nodes;
+    }
     return ret;
 }
 
+Index inf::EventTree::get_n_nodes_total() const { return m_n_nodes_total; }
+
+Index inf::EventTree::get_breadth_at_depth(Index const depth) const {
+    ASSERT_TRUE(m_finished_initialization)
+    ASSERT_LT(depth, get_depth())
+
+    return m_breadths[depth];
+}
+
+Index inf::EventTree::count_leaves_from(inf::EventTree::NodePos const &node_pos) const {
+    ASSERT_TRUE(m_finished_initialization)
+    ASSERT_LT(node_pos.depth, get_depth())
+    ASSERT_LT(node_pos.node_index, m_n_leaves_from[node_pos.depth].size())
+
+    return m_n_leaves_from[node_pos.depth][node_pos.node_index];
+}
+
 bool inf::EventTree::is_initialized() const {
     return m_finished_initialization;
 }
@@ -363,6 +658,11 @@ void inf::EventTree::io(util::FileStream &stream) {
 
     // 2 - Node cache
     {
+        // The file format stores a list of inf::EventTree::Node per depth, so when writing,
+        // we temporarily rebuild these nodes from the frozen layout
+        if (not stream.is_reading())
+            m_node_cache = get_node_cache();
+
         stream.io(m_node_cache);
 
         if (stream.is_reading()) {
@@ -390,15 +690,21 @@ void inf::EventTree::io(util::FileStream &stream) {
         }
     }
 
-    // 3 - Info
+    // 3 - Frozen layout and info
     {
         if (stream.is_reading()) {
+            // The nodes read from the file have no use for the hash index
+            m_node_index.clear();
+            m_node_index.shrink_to_fit();
+
+            freeze();
+            m_finished_initialization = true;
             init_info();
+        } else {
+            m_node_cache.clear();
+            m_node_cache.shrink_to_fit();
         }
     }
-
-    if (stream.is_reading())
-        m_finished_initialization = true;
 }
 
 bool inf::EventTree::operator==(inf::EventTree const &other) const {
@@ -411,18 +717,9 @@ bool inf::EventTree::operator==(inf::EventTree const &other) const {
     if (not other.is_initialized())
         return false;
 
-    for (Index depth : util::Range(get_depth())) {
-        if (m_node_cache[depth].size() != other.m_node_cache[depth].size())
-            return false;
-
-        for (Index node_i : util::Range(m_node_cache[depth].size())) {
-            if (m_node_cache[depth][node_i] !=
-                other.m_node_cache[depth][node_i])
-                return false;
-        }
-    }
-
-    return true;
+    // Since the frozen layout numbers the nodes in a canonical way and is padded with zeros, we can compare it directly
+    return m_frozen_data_size == other.m_frozen_data_size and
+           std::memcmp(m_frozen_data, other.m_frozen_data, m_frozen_data_size) == 0;
 }
 
 bool inf::EventTree::operator!=(inf::EventTree const &other) const {
@@ -430,34 +727,53 @@ bool inf::EventTree::operator!=(inf::EventTree const &other) const {
 }
 
 void inf::EventTree::init_info() {
-    // sizeof(inf::EventTree) accounts for the std::vector m_node_cache and the
-    // root index
+    // sizeof(inf::EventTree) accounts for the pointers to the frozen layout
     m_memory_footprint = sizeof(inf::EventTree) +
-                         m_depth * sizeof(std::vector<inf::EventTree::Node>);
-
-    inf::EventTree::NodePos::Queue queue = get_root_children_queue();
-
-    // Number of leaves
-    m_n_leaves = 0;
-    for (inf::EventTree::NodePos const &root_node_pos : queue) {
-        m_n_leaves += count_leaves_from(root_node_pos);
+                         m_depth * sizeof(inf::EventTree::FrozenDepth) +
+                         m_frozen_data_size;
+
+    // Number of leaves below each node, from the last depth upwards
+    m_n_leaves_from = std::vector<std::vector<Index>>(m_depth);
+    m_n_leaves_from.back() = std::vector<Index>(m_frozen.back().n_nodes, 1);
+    for (Index depth = m_depth - 1; depth-- > 0;) {
+        inf::EventTree::FrozenDepth const &frozen_depth = m_frozen[depth];
+        std::vector<Index> const &next_n_leaves_from = m_n_leaves_from[depth + 1];
+        std::vector<Index> &n_leaves_from = m_n_leaves_from[depth];
+
+        n_leaves_from = std::vector<Index>(frozen_depth.n_nodes, 0);
+        for (Index const node_index : util::Range(frozen_depth.n_nodes)) {
+            for (Index child_i : util::Range(frozen_depth.child_offsets[node_index], frozen_depth.child_offsets[node_index + 1]))
+                n_leaves_from[node_index] += next_n_leaves_from[frozen_depth.children[child_i]];
+        }
     }
 
-    // Number of nodes
-    m_n_nodes_total = 0;
-    while (not queue.empty()) {
-        inf::EventTree::NodePos node_pos = util::pop_back(queue);
+    // Number of paths from the root to each node, from the first depth downwards, which sum up to the breadths
+    m_breadths = std::vector<Index>(m_depth, 0);
+    std::vector<Index> n_paths_to(m_frozen[0].n_nodes, 1);
+    for (Index const depth : util::Range(m_depth)) {
+        inf::EventTree::FrozenDepth const &frozen_depth = m_frozen[depth];
 
-        ++m_n_nodes_total;
+        for (Index const n_paths : n_paths_to)
+            m_breadths[depth] += n_paths;
 
-        if (node_pos.depth < get_depth() - 1) {
-            add_children_to_queue(queue, node_pos);
-        }
-    }
+        if (depth == m_depth - 1)
+            break;
 
-    for (Index const depth : util::Range(m_depth)) {
-        for (inf::EventTree::Node const &node : m_node_cache[depth]) {
-            m_memory_footprint += node.get_memory_footprint();
+        std::vector<Index> next_n_paths_to(m_frozen[depth + 1].n_nodes, 0);
+        for (Index const node_index : util::Range(frozen_depth.n_nodes)) {
+            for (Index child_i : util::Range(frozen_depth.child_offsets[node_index], frozen_depth.child_offsets[node_index + 1]))
+                next_n_paths_to[frozen_depth.children[child_i]] += n_paths_to[node_index];
         }
+        n_paths_to = std::move(next_n_paths_to);
     }
+
+    // Number of leaves
+    m_n_leaves = m_breadths.back();
+    ASSERT_EQUAL(m_n_leaves, util::sum(m_n_leaves_from[0]))
+
+    // Number of nodes
+    m_n_nodes_total = util::sum(m_breadths);
+
+    for (std::vector<Index> const &n_leaves_from : m_n_leaves_from)
+        m_memory_footprint += n_leaves_from.size() * sizeof(Index);
 }
@@ -3,8 +3,10 @@
 #include "../../util/debug.h"
 #include "../../util/file_stream.h"
 #include "../../util/loggable.h"
+#include "../../util/mapped_file.h"
 #include "event.h"
 #include <memory>
+#include <unordered_map>
 
 namespace inf {
 
@@ -101,6 +103,22 @@ namespace inf {
  *     { N[2][0] = (0,{}), N[2][1] = (1,{}) }
  * }
  * ```
+ *
+ * ### Frozen layout
+ *
+ * While the tree is being populated with inf::EventTree::insert_node(), each inf::EventTree::Node owns its own array of children.
+ * Once inf::EventTree::finish_initialization() is called, the tree becomes read-only and is stored in a flat layout instead:
+ * for each depth, a contiguous array of outcomes, a contiguous array of child indices, and an array of offsets such that
+ * the children of the node `i` are found between the offsets `i` and `i+1` (this is often called the compressed sparse row format).
+ * The nodes of each depth are furthermore renumbered in the order in which a depth-first traversal of the tree first visits them,
+ * so that walking down the tree mostly reads memory sequentially.
+ * The indices of this layout are stored as inf::EventTree::CompactIndex to save memory.
+ * Note that the numbering of the root children, i.e., of the nodes at depth 0, is unchanged by this renumbering.
+ *
+ * All the arrays of the frozen layout live in a single buffer, which can be saved as a binary image with inf::EventTree::write_image().
+ * Such an image is loaded back by inf::EventTree::read_image() by mapping the file into memory (see util::MappedFile), so that the
+ * inf::EventTree then works directly on the mapped pages, without parsing or copying the data.
+ *
  * \warning The implementation of inf::EventTree::Node is such that no node can have more than
  * 256 children.
  * */
@@ -109,13 +127,18 @@ class EventTree : public util::Loggable, public util::Serializable {
     /*! \brief An inf::EventTree can take some time to initialize, and this option is used to control
      * whether an inf::EventTree should be written to or read from disk. */
     enum class IO {
-        read,  //!< To read an inf::EventTree from a file
-        write, //!< To write an inf::EventTree to a file
+        read,  //!< To read an inf::EventTree from a file, preferably from its binary image (see inf::EventTree::read_image())
+        write, //!< To write an inf::EventTree to a file, both in text format and as a binary image
         none   //!< To do neither of the above
     };
 
     static void log(inf::EventTree::IO io);
 
+    /*! \brief The type of the node indices and child offsets stored in the frozen layout of the inf::EventTree
+     * \details Using 32 bits rather than the 64 bits of ::Index halves the memory taken by the child indices.
+     * This is hard-asserted to be enough when inf::EventTree::finish_initialization() is called. */
+    typedef uint32_t CompactIndex;
+
     /*! \brief This lightweight data structure uniquely identifies a node in some inf::EventTree.
      * \details In the inf::EventTree, the inf::EventTree::Node are stored in a two-dimensional array:
      *  - the first index of this two-dimensional array, the \p depth index, represents the depth (distance)
@@ -141,6 +164,8 @@ class EventTree : public util::Loggable, public util::Serializable {
     };
 
     /*! \brief A node of the inf::EventTree, storing an outcome and some other inf::EventTreee::Node as children
+     * \details This class is used while populating the inf::EventTree and for serialization. Once
+     * inf::EventTree::finish_initialization() is called, the nodes are stored in the frozen layout described above.
      * \note This class is meant to be lightweight, which is why we want to avoid making it a virtual class.
      * Hence, although an inf::EventTree::Node is effectively a util::Serializable, we do not make it explicitly so.
      * (The reason is that a virtual class instance takes up a tiny bit more memory in C++.)
@@ -198,6 +223,7 @@ class EventTree : public util::Loggable, public util::Serializable {
     };
 
     typedef std::unique_ptr<inf::EventTree> UniquePtr;
+    typedef std::shared_ptr<const inf::EventTree> ConstPtr;
 
     /*! \brief Construct an empty inf::EventTree, initialized with a fixed \p depth */
     EventTree(Index const depth);
@@ -223,12 +249,30 @@ class EventTree : public util::Loggable, public util::Serializable {
      * - If it does, the method simply returns the ::Index of this existing inf::EventTree::Node within the internal list `m_node_cache[depth]`.
      * - If it does not, the method appends a new inf::EventTree::Node at the end of `m_node_cache[depth]`, and return the corresponding ::Index.
      * The returned ::Index allows the user to create parents of this node.
+     *
+     * The lookup goes through the hash index `m_node_index[depth]`, so that inserting a node takes constant time on average
+     * rather than time linear in the number of cached nodes at that depth.
      * */
     Index insert_node(Index const depth, inf::Outcome const outcome, std::vector<Index> const &children);
 
+    /*! \brief Inserts all the nodes populated so far in the inf::EventTree \p other into this inf::EventTree
+     * \details Both inf::EventTree must have the same depth and must not have been finished yet (see inf::EventTree::finish_initialization()).
+     * The nodes of \p other are inserted bottom-up with inf::EventTree::insert_node(), so that they are deduplicated against
+     * the nodes already present in this inf::EventTree.
+     * This is used by inf::TreeFiller to combine the subtrees that were filled by different threads.
+     * \return For each depth, the list mapping the ::Index of a node in \p other to the ::Index of the same node in this inf::EventTree */
+    std::vector<std::vector<Index>> merge_nodes(inf::EventTree const &other);
+
+    /*! \brief Reads or writes the nodes inserted so far in an inf::EventTree that is still being populated
+     * \details Contrary to inf::EventTree::io(), this does not require (nor perform) inf::EventTree::finish_initialization(),
+     * so that the population of the inf::EventTree can be resumed after reading.
+     * When reading, the inf::EventTree must be empty.
+     * This is used by inf::TreeFiller to checkpoint the filling of large trees. */
+    void io_nodes(util::FileStream &stream);
+
     /*! \brief This method needs to be called after inserting all the nodes of the tree
      * \details This method initializes the relevant metadata (size, etc) of the inf::EventTree,
-     * and optimizes the memory that the inf::EventTree uses.
+     * and optimizes the memory that the inf::EventTree uses by converting it to the frozen layout described above.
      * The idea of this is that the user should first insert the relevant
      * nodes with inf::EventTree::insert_node(), and then call inf::EventTree::finish_initialization().
      * The rest of the class features some soft assertions making sure that this method was indeed called. */
@@ -256,16 +300,27 @@ class EventTree : public util::Loggable, public util::Serializable {
     Index get_n_nodes_total() const;
 
     /*! \brief This method is typically used together with an inf::EventTree::NodePos::Queue to traverse the inf::EventTree. */
-    inf::EventTree::Node const &get_node(inf::EventTree::NodePos const &node_pos) const {
+    inf::Outcome get_outcome(inf::EventTree::NodePos const &node_pos) const {
+        ASSERT_TRUE(m_finished_initialization)
         ASSERT_LT(node_pos.depth, m_depth)
-        ASSERT_LT(node_pos.node_index, m_node_cache[node_pos.depth].size())
-        return m_node_cache[node_pos.depth][node_pos.node_index];
+        ASSERT_LT(node_pos.node_index, m_frozen[node_pos.depth].n_nodes)
+        return m_frozen[node_pos.depth].outcomes[node_pos.node_index];
+    }
+
+    /*! \brief The number of children of the node indicated by \p node_pos */
+    Index get_n_children(inf::EventTree::NodePos const &node_pos) const {
+        ASSERT_TRUE(m_finished_initialization)
+        ASSERT_LT(node_pos.depth, m_depth)
+        ASSERT_LT(node_pos.node_index, m_frozen[node_pos.depth].n_nodes)
+        inf::EventTree::CompactIndex const *const offsets = m_frozen[node_pos.depth].child_offsets + node_pos.node_index;
+        return offsets[1] - offsets[0];
     }
 
     /*! \brief The number of root children, i.e., of nodes that connect directly to the root of the tree.
      * \details In the case of the binary tree representing the set \f$\{0,1\}^{\times3}\f$, this would be 2. */
     Index get_root_children_count() const {
-        return m_node_cache[0].size();
+        ASSERT_TRUE(m_finished_initialization)
+        return m_frozen[0].n_nodes;
     }
 
     /*! \brief Returns the root children as a queue to start traversing the tree */
@@ -282,24 +337,43 @@ class EventTree : public util::Loggable, public util::Serializable {
 
     /*! \brief Returns the breadth (number of nodes, counting duplicates) of the tree at \p depth
      * \details In the case of the binary tree representing the set \f$\{0,1\}^{\times3}\f$, this would be
-     * 2 at `depth = 0`, 4 at `depth = 1` and 8 at `depth = 2`. */
+     * 2 at `depth = 0`, 4 at `depth = 1` and 8 at `depth = 2`.
+     * This is precomputed by inf::EventTree::init_info(), so this takes constant time. */
     Index get_breadth_at_depth(Index const depth) const;
 
-    /*! \brief Returns the number of leaves (counting duplicates) of the subtree that includes all descendants of the given node */
+    /*! \brief Returns the number of leaves (counting duplicates) of the subtree that includes all descendants of the given node
+     * \details This is precomputed by inf::EventTree::init_info(), so this takes constant time. */
     Index count_leaves_from(inf::EventTree::NodePos const &node_pos) const;
 
     /*! \brief Appends to \p queue the children of the inf::EventTree::Node indicated by \p node_pos */
     void add_children_to_queue(inf::EventTree::NodePos::Queue &queue, inf::EventTree::NodePos const &node_pos) const {
 
-        inf::EventTree::Node const &the_node = get_node(node_pos);
-        Index const n_children = the_node.n_children;
-        Index const *const children = the_node.children;
+        ASSERT_TRUE(m_finished_initialization)
+        ASSERT_LT(node_pos.depth, m_depth)
+        ASSERT_LT(node_pos.node_index, m_frozen[node_pos.depth].n_nodes)
+
+        inf::EventTree::CompactIndex const *const offsets = m_frozen[node_pos.depth].child_offsets + node_pos.node_index;
+        inf::EventTree::CompactIndex const *const children = m_frozen[node_pos.depth].children;
         Index const new_depth = node_pos.depth + 1;
 
-        for (Index child_node_index(0); child_node_index < n_children; ++child_node_index)
-            queue.emplace_back(new_depth, children[child_node_index]);
+        for (Index child_i(offsets[0]); child_i < offsets[1]; ++child_i)
+            queue.emplace_back(new_depth, children[child_i]);
     }
 
+    /*! \brief Writes the frozen layout of the inf::EventTree to the binary image \p filename, to which the extension `.image` is appended
+     * \details The image starts with a header holding a version number and the \p metadata, similarly to util::OutputFileStream.
+     * The frozen layout is then written as is, so that the image depends on the endianness of the machine, just like the
+     * util::FileStream::Format::binary format. */
+    void write_image(std::string const &filename, std::string const &metadata) const;
+    /*! \brief Initializes the inf::EventTree from the binary image \p filename (without extension) written by inf::EventTree::write_image()
+     * \details The file is mapped into memory and the inf::EventTree points directly into it. Only the header and the consistency of the
+     * child indices are checked, which is much faster than reading the text format.
+     * Throws an error if the metadata of the image does not match \p expected_metadata.
+     * \warning This replaces inf::EventTree::finish_initialization(), and should be called on an empty inf::EventTree. */
+    void read_image(std::string const &filename, std::string const &expected_metadata);
+    /*! \brief Checks whether the binary image \p filename (without extension) exists */
+    static bool image_exists(std::string const &filename);
+
     /*! \brief This method allows to check that inf::EventTree::finish_initialization() was properly called
      * \details The idea of this is that the user should first insert the relevant
      * nodes with inf::EventTree::insert_node(), and then call inf::EventTree::finish_initialization(). */
@@ -314,12 +388,62 @@ class EventTree : public util::Loggable, public util::Serializable {
   private:
     /*! \brief The length from root to any leaf */
     Index const m_depth;
-    /*! \brief We store one list of unique nodes per depth
+    /*! \brief We store one list of unique nodes per depth while populating the tree
      * \details See the general class description for an explanation of the compression
      * algorithm underlying this data structure.
      * The root children are stored in `m_node_cache[0]`, while the unique leaves
-     * are stored in `m_node_cache.back()`. */
+     * are stored in `m_node_cache.back()`.
+     * This is emptied by inf::EventTree::finish_initialization(), which converts it to the frozen layout `m_frozen`. */
     std::vector<std::vector<inf::EventTree::Node>> m_node_cache;
+    /*! \brief For each depth, maps the hash of an inf::EventTree::Node (see inf::EventTree::hash_node()) to the indices
+     * of the nodes of `m_node_cache[depth]` that have this hash
+     * \details This is only used by inf::EventTree::insert_node() to quickly find duplicate nodes, and is freed by
+     * inf::EventTree::finish_initialization(). */
+    std::vector<std::unordered_multimap<std::size_t, Index>> m_node_index;
+    /*! \brief The hash of an inf::EventTree::Node with outcome \p outcome and children \p children_vec, used as a key of `m_node_index` */
+    static std::size_t hash_node(inf::Outcome const outcome, std::vector<Index> const &children_vec);
+
+    /*! \brief The frozen layout of the nodes at some depth of the inf::EventTree
+     * \details The arrays point into `m_frozen_data`. */
+    struct FrozenDepth {
+        /*! \brief The number of nodes at this depth */
+        Index n_nodes;
+        /*! \brief `outcomes[i]` is the outcome of the node `i` */
+        inf::Outcome const *outcomes;
+        /*! \brief The children of the node `i` are stored in `children` from `child_offsets[i]` (included)
+         * to `child_offsets[i+1]` (excluded), so that this array has `n_nodes + 1` elements */
+        inf::EventTree::CompactIndex const *child_offsets;
+        /*! \brief The concatenated children of the nodes at this depth, as indices of nodes at the next depth */
+        inf::EventTree::CompactIndex const *children;
+    };
+    /*! \brief The frozen layout, one inf::EventTree::FrozenDepth per depth */
+    std::vector<inf::EventTree::FrozenDepth> m_frozen;
+    /*! \brief The buffer holding all the arrays of the frozen layout
+     * \details This points either into `m_frozen_storage` or into `m_mapped_file`.
+     * It starts with the depth and the number of nodes and children at each depth (as ::Index), and then holds, for each depth,
+     * the outcomes followed by the child offsets and children, each section being padded to a multiple of 8 bytes. */
+    char const *m_frozen_data;
+    /*! \brief The size in bytes of `m_frozen_data` */
+    Index m_frozen_data_size;
+    /*! \brief Owns `m_frozen_data` when the inf::EventTree was built in memory
+     * \details The memory allocated by a `std::vector` is suitably aligned for any arithmetic type. */
+    std::vector<char> m_frozen_storage;
+    /*! \brief Owns `m_frozen_data` when the inf::EventTree was read with inf::EventTree::read_image() */
+    std::unique_ptr<util::MappedFile> m_mapped_file;
+    /*! \brief Converts `m_node_cache` to the frozen layout, renumbering the nodes in depth-first order, and then frees `m_node_cache`
+     * \details The nodes of `m_node_cache` that cannot be reached from the root are dropped. */
+    void freeze();
+    /*! \brief Points `m_frozen` into the buffer \p frozen_data of \p frozen_data_size bytes, checking its consistency */
+    void set_frozen_data(char const *frozen_data, Index frozen_data_size);
+
+    /*! \brief Identifies a binary image written by inf::EventTree::write_image(), which also allows to detect an endianness mismatch */
+    static Index const image_magic;
+    /*! \brief This version number should be changed if the format of the binary image is modified */
+    static Index const image_version;
+    /*! \brief The extension of the binary image files */
+    static std::string const image_extension;
+    /*! \brief Rebuilds a node cache from the frozen layout, which is used to serialize the inf::EventTree */
+    std::vector<std::vector<inf::EventTree::Node>> get_node_cache() const;
 
     /*! \brief The idea of this test is that the user should first insert the relevant
      * nodes with inf::EventTree::insert_node(), and then call inf::EventTree::finish_initialization(). */
@@ -331,8 +455,15 @@ class EventTree : public util::Loggable, public util::Serializable {
     Index m_n_leaves;
     /*! \brief The number of nodes, see inf::EventTree::get_n_nodes_total() */
     Index m_n_nodes_total;
+    /*! \brief `m_breadths[depth]` is the breadth of the tree at \p depth, see inf::EventTree::get_breadth_at_depth() */
+    std::vector<Index> m_breadths;
+    /*! \brief `m_n_leaves_from[depth][i]` is the number of leaves of the subtree starting at the node `i` at \p depth,
+     * see inf::EventTree::count_leaves_from() */
+    std::vector<std::vector<Index>> m_n_leaves_from;
     /*! \brief This method is called by inf::EventTree::finish_initialization() to initialize the different size-related
-     * fields of the inf::EventTree. */
+     * fields of the inf::EventTree.
+     * \details Since the subtrees are heavily shared, the numbers of leaves and breadths are computed by dynamic programming
+     * over the unique nodes rather than by traversing the tree, so that this takes time linear in the number of cached nodes. */
     void init_info();
 };
 
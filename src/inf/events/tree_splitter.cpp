@@ -145,25 +145,21 @@ std::vector<inf::TreeSplitter::PathAndLeaves> inf::TreeSplitter::get_paths_and_l
     ASSERT_LT(depth, m_event_tree.get_depth())
     ASSERT_EQUAL(breadth, m_event_tree.get_breadth_at_depth(depth))
 
-    // Initialize paths_and_leaves to a list of length breadth with all paths set to the right
-    // size but with all zero indices for now. Furthermore, initialize the number of leaves to zero.
-    std::vector<PathAndLeaves> paths_and_leaves(breadth, {std::vector<Index>(depth + 1), 0});
+    std::vector<PathAndLeaves> paths_and_leaves;
+    paths_and_leaves.reserve(breadth);
 
-    // Initialize paths_and_leaves
-    Index path_index = 0;
+    // The path from the root to the current node. When popping a node at some depth, the entries of
+    // current_path before that depth always describe the path to its parent.
+    Path current_path(depth + 1);
     inf::EventTree::NodePos::Queue queue = m_event_tree.get_root_children_queue();
     while (not queue.empty()) {
         inf::EventTree::NodePos node_pos = util::pop_back(queue);
 
-        // This method does a bit too many calculations, I guess, but it works
-        for (Index other_path_index : util::Range(path_index, breadth)) {
-            paths_and_leaves[other_path_index].path[node_pos.depth] = node_pos.node_index;
-        }
+        current_path[node_pos.depth] = node_pos.node_index;
 
         if (node_pos.depth == depth) {
-            // We reached the end of this path. Count leaves and move on.
-            paths_and_leaves[path_index].n_leaves = m_event_tree.count_leaves_from(node_pos);
-            ++path_index;
+            // We reached the end of this path. The number of leaves is precomputed by the inf::EventTree.
+            paths_and_leaves.push_back({current_path, m_event_tree.count_leaves_from(node_pos)});
         } else {
             m_event_tree.add_children_to_queue(queue, node_pos);
         }
@@ -91,8 +91,8 @@ class TreeSplitter {
     /*! \brief This method returns all the paths at the given depth, ordered according to the number of leaves they carry.
      * The number of leaves they each carry is also returned.
      * \param depth
-     * \param breadth The method inf::EventTree::get_breadth_at_depth() can be a bit slow, and it was already invoked
-     * before we call this method, so we simply pass the \p breadth as a parameter instead of recomputing it. */
+     * \param breadth The breadth of the inf::EventTree at \p depth, see inf::EventTree::get_breadth_at_depth(), which was already
+     * invoked before we call this method. */
     std::vector<inf::TreeSplitter::PathAndLeaves> get_paths_and_leaves(Index const depth,
                                                                        Index const breadth) const;
 
@@ -7,11 +7,18 @@ inf::FeasOptions::FeasOptions()
     : m_inflation_size{},
       m_constraint_set_description{},
       m_search_mode(inf::Optimizer::SearchMode::tree_search),
+      m_thread_schedule(inf::Optimizer::ThreadSchedule::work_stealing),
+      m_node_order(inf::Optimizer::NodeOrder::tree),
+      m_lower_bound(inf::Optimizer::LowerBound::per_term),
+      m_pre_oracle(inf::Optimizer::PreOracle::none),
       m_use_distr_symmetries(inf::Inflation::UseDistrSymmetries::yes),
+      m_party_order(inf::Inflation::PartyOrder::standard),
       m_stop_mode(inf::Optimizer::StopMode::opt),
       m_fw_algo(inf::FrankWolfe::Algo::fully_corrective),
       m_store_bounds(inf::DualVector::StoreBounds::yes),
       m_n_threads(1),
+      m_n_processes(1),
+      m_n_events_per_optimization(1),
       m_symtree_io(inf::EventTree::IO::none) {}
 
 void inf::FeasOptions::log() const {
@@ -25,8 +32,18 @@ void inf::FeasOptions::log() const {
     util::logger << "Options:" << util::cr << "    ";
     inf::Optimizer::log(m_search_mode);
     util::logger << util::cr << "    ";
+    inf::Optimizer::log(m_thread_schedule);
+    util::logger << util::cr << "    ";
+    inf::Optimizer::log(m_node_order);
+    util::logger << util::cr << "    ";
+    inf::Optimizer::log(m_lower_bound);
+    util::logger << util::cr << "    ";
+    inf::Optimizer::log(m_pre_oracle);
+    util::logger << util::cr << "    ";
     inf::Inflation::log(m_use_distr_symmetries);
     util::logger << util::cr << "    ";
+    inf::Inflation::log(m_party_order);
+    util::logger << util::cr << "    ";
     inf::Optimizer::log(m_stop_mode);
     util::logger << util::cr << "    ";
     inf::FrankWolfe::log(m_fw_algo);
@@ -36,6 +53,12 @@ void inf::FeasOptions::log() const {
     util::logger << util::begin_comment << "n_threads = " << util::end_comment;
     util::logger << m_n_threads;
     util::logger << util::cr << "    ";
+    util::logger << util::begin_comment << "n_processes = " << util::end_comment;
+    util::logger << m_n_processes;
+    util::logger << util::cr << "    ";
+    util::logger << util::begin_comment << "n_events_per_optimization = " << util::end_comment;
+    util::logger << m_n_events_per_optimization;
+    util::logger << util::cr << "    ";
     inf::EventTree::log(m_symtree_io);
     util::logger << util::cr;
 
@@ -59,11 +82,36 @@ inf::FeasOptions &inf::FeasOptions::set(inf::Optimizer::SearchMode search_mode)
     return *this;
 }
 
+inf::FeasOptions &inf::FeasOptions::set(inf::Optimizer::ThreadSchedule thread_schedule) {
+    m_thread_schedule = thread_schedule;
+    return *this;
+}
+
+inf::FeasOptions &inf::FeasOptions::set(inf::Optimizer::NodeOrder node_order) {
+    m_node_order = node_order;
+    return *this;
+}
+
+inf::FeasOptions &inf::FeasOptions::set(inf::Optimizer::LowerBound lower_bound) {
+    m_lower_bound = lower_bound;
+    return *this;
+}
+
+inf::FeasOptions &inf::FeasOptions::set(inf::Optimizer::PreOracle pre_oracle) {
+    m_pre_oracle = pre_oracle;
+    return *this;
+}
+
 inf::FeasOptions &inf::FeasOptions::set(inf::Inflation::UseDistrSymmetries use_distr_symmetries) {
     m_use_distr_symmetries = use_distr_symmetries;
     return *this;
 }
 
+inf::FeasOptions &inf::FeasOptions::set(inf::Inflation::PartyOrder party_order) {
+    m_party_order = party_order;
+    return *this;
+}
+
 inf::FeasOptions &inf::FeasOptions::set(inf::Optimizer::StopMode stop_mode) {
     m_stop_mode = stop_mode;
     return *this;
@@ -84,6 +132,16 @@ inf::FeasOptions &inf::FeasOptions::set_n_threads(Index n_threads) {
     return *this;
 }
 
+inf::FeasOptions &inf::FeasOptions::set_n_processes(Index n_processes) {
+    m_n_processes = n_processes;
+    return *this;
+}
+
+inf::FeasOptions &inf::FeasOptions::set_n_events_per_optimization(Index n_events) {
+    m_n_events_per_optimization = n_events;
+    return *this;
+}
+
 inf::FeasOptions &inf::FeasOptions::set(inf::EventTree::IO symtree_io) {
     m_symtree_io = symtree_io;
     return *this;
@@ -103,10 +161,30 @@ inf::Optimizer::SearchMode inf::FeasOptions::get_search_mode() const {
     return m_search_mode;
 }
 
+inf::Optimizer::ThreadSchedule inf::FeasOptions::get_thread_schedule() const {
+    return m_thread_schedule;
+}
+
+inf::Optimizer::NodeOrder inf::FeasOptions::get_node_order() const {
+    return m_node_order;
+}
+
+inf::Optimizer::LowerBound inf::FeasOptions::get_lower_bound() const {
+    return m_lower_bound;
+}
+
+inf::Optimizer::PreOracle inf::FeasOptions::get_pre_oracle() const {
+    return m_pre_oracle;
+}
+
 inf::Inflation::UseDistrSymmetries inf::FeasOptions::get_use_distr_symmetries() const {
     return m_use_distr_symmetries;
 }
 
+inf::Inflation::PartyOrder inf::FeasOptions::get_party_order() const {
+    return m_party_order;
+}
+
 inf::Optimizer::StopMode inf::FeasOptions::get_stop_mode() const {
     return m_stop_mode;
 }
@@ -123,6 +201,14 @@ Index inf::FeasOptions::get_n_threads() const {
     return m_n_threads;
 }
 
+Index inf::FeasOptions::get_n_processes() const {
+    return m_n_processes;
+}
+
+Index inf::FeasOptions::get_n_events_per_optimization() const {
+    return m_n_events_per_optimization;
+}
+
 inf::EventTree::IO inf::FeasOptions::get_symtree_io() const {
     return m_symtree_io;
 }
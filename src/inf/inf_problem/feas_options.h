@@ -45,11 +45,18 @@ class FeasOptions : public util::Loggable {
     FeasOptions &set(inf::Inflation::Size const &inflation_size);
     FeasOptions &set(inf::ConstraintSet::Description const &constraint_set_description);
     FeasOptions &set(inf::Optimizer::SearchMode search_mode);
+    FeasOptions &set(inf::Optimizer::ThreadSchedule thread_schedule);
+    FeasOptions &set(inf::Optimizer::NodeOrder node_order);
+    FeasOptions &set(inf::Optimizer::LowerBound lower_bound);
+    FeasOptions &set(inf::Optimizer::PreOracle pre_oracle);
     FeasOptions &set(inf::Inflation::UseDistrSymmetries use_distr_symmetries);
+    FeasOptions &set(inf::Inflation::PartyOrder party_order);
     FeasOptions &set(inf::Optimizer::StopMode stop_mode);
     FeasOptions &set(inf::FrankWolfe::Algo fw_algo);
     FeasOptions &set(inf::DualVector::StoreBounds store_bounds);
     FeasOptions &set_n_threads(Index n_threads);
+    FeasOptions &set_n_processes(Index n_processes);
+    FeasOptions &set_n_events_per_optimization(Index n_events);
     FeasOptions &set(inf::EventTree::IO symtree_io);
 
     // getters
@@ -57,11 +64,18 @@ class FeasOptions : public util::Loggable {
     inf::Inflation::Size get_inflation_size() const;
     inf::ConstraintSet::Description const &get_constraint_set_description() const;
     inf::Optimizer::SearchMode get_search_mode() const;
+    inf::Optimizer::ThreadSchedule get_thread_schedule() const;
+    inf::Optimizer::NodeOrder get_node_order() const;
+    inf::Optimizer::LowerBound get_lower_bound() const;
+    inf::Optimizer::PreOracle get_pre_oracle() const;
     inf::Inflation::UseDistrSymmetries get_use_distr_symmetries() const;
+    inf::Inflation::PartyOrder get_party_order() const;
     inf::Optimizer::StopMode get_stop_mode() const;
     inf::FrankWolfe::Algo get_fw_algo() const;
     inf::DualVector::StoreBounds get_store_bounds() const;
     Index get_n_threads() const;
+    Index get_n_processes() const;
+    Index get_n_events_per_optimization() const;
     Index get_vis_param() const;
     inf::EventTree::IO get_symtree_io() const;
 
@@ -72,11 +86,18 @@ class FeasOptions : public util::Loggable {
     // FeasOptions
 
     inf::Optimizer::SearchMode m_search_mode;
+    inf::Optimizer::ThreadSchedule m_thread_schedule;
+    inf::Optimizer::NodeOrder m_node_order;
+    inf::Optimizer::LowerBound m_lower_bound;
+    inf::Optimizer::PreOracle m_pre_oracle;
     inf::Inflation::UseDistrSymmetries m_use_distr_symmetries;
+    inf::Inflation::PartyOrder m_party_order;
     inf::Optimizer::StopMode m_stop_mode;
     inf::FrankWolfe::Algo m_fw_algo;
     inf::DualVector::StoreBounds m_store_bounds;
     Index m_n_threads;
+    Index m_n_processes;
+    Index m_n_events_per_optimization;
     inf::EventTree::IO m_symtree_io;
 };
 
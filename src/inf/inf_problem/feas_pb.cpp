@@ -27,7 +27,9 @@ inf::FeasProblem::FeasProblem(inf::TargetDistr::ConstPtr const &distribution,
               std::make_shared<const inf::Inflation>(
                   distribution,
                   options->get_inflation_size(),
-                  options->get_use_distr_symmetries()),
+                  options->get_use_distr_symmetries(),
+                  options->get_party_order(),
+                  options->get_constraint_set_description()),
               options->get_constraint_set_description(),
               options->get_store_bounds())),
       m_frank_wolfe(
@@ -57,7 +59,12 @@ void inf::FeasProblem::log_info_and_init_optimizer() {
         m_options->get_search_mode(),
         m_constraint_set,
         m_options->get_symtree_io(),
-        m_options->get_n_threads());
+        m_options->get_n_threads(),
+        m_options->get_thread_schedule(),
+        m_options->get_node_order(),
+        m_options->get_lower_bound(),
+        m_options->get_pre_oracle(),
+        m_options->get_n_processes());
 
     m_optimizer->log_info();
 
@@ -173,6 +180,13 @@ inf::FeasProblem::Status inf::FeasProblem::get_feasibility() {
 
         // The distribution might be feasible...
         memorize_event(sol.get_inflation_event());
+
+        // The other events violating the current dual vector are also worth adding to the active set of the Frank-Wolfe algorithm,
+        // this saves the optimizations that would otherwise find them one by one
+        for (inf::Optimizer::ScoredEvent const &scored_event : sol.get_other_scored_events()) {
+            if (scored_event.first <= 0)
+                memorize_event(scored_event.second);
+        }
     }
 
     LOG_END_SECTION
@@ -221,7 +235,13 @@ void inf::FeasProblem::read_dual_vector_from_file(std::string const &filename, s
 }
 
 inf::Optimizer::Solution inf::FeasProblem::minimize_dual_vector() const {
-    return m_optimizer->optimize(m_options->get_stop_mode());
+    if (m_options->get_pre_oracle() == inf::Optimizer::PreOracle::none)
+        return m_optimizer->optimize(m_options->get_stop_mode(), m_options->get_n_events_per_optimization());
+
+    // The events stored by the Frank-Wolfe algorithm are the seeds of the inf::LocalSearch
+    return m_optimizer->optimize(m_options->get_stop_mode(),
+                                 m_options->get_n_events_per_optimization(),
+                                 m_frank_wolfe->get_stored_events());
 }
 
 inf::FeasProblem::Status inf::FeasProblem::read_and_check_dual_vector(std::string const &filename,
@@ -104,7 +104,8 @@ class FeasProblem {
     void read_dual_vector_from_file(std::string const &filename, std::string const &metadata);
 
     /*! \brief This minimizes the inner product between the current dual vector stored in `m_constraint_set`, see inf::Optimizer
-     * \details If the returned inf::Optimizer::Solution has `inf::Optimizer::Solution::get_inflation_event_score() > 0`, then this proves the nonlocality of the target distribution. */
+     * \details If the returned inf::Optimizer::Solution has `inf::Optimizer::Solution::get_inflation_event_score() > 0`, then this proves the nonlocality of the target distribution.
+     * With inf::Optimizer::PreOracle::local_search, the events stored by the inf::FrankWolfe algorithm seed the inf::LocalSearch. */
     inf::Optimizer::Solution minimize_dual_vector() const;
 
     /*! \brief This call inf::FeasProblem::read_dual_vector_from_file(), then inf::FeasProblem::minimize_dual_vector(),
@@ -1,10 +1,19 @@
 #include "inflation.h"
 #include "../../util/debug.h"
+#include "../../util/file_stream.h"
 #include "../../util/logger.h"
 #include "../../util/math.h"
 #include "../../util/permutations.h"
+#include "../constraints/constraint_parser.h"
 #include "../inf_problem/tree_filler.h"
 
+// For std::sort
+#include <algorithm>
+// For std::setw and std::setfill
+#include <iomanip>
+// For std::stringstream
+#include <sstream>
+
 void inf::Inflation::log(inf::Inflation::UseDistrSymmetries use_distr_symmetries) {
     util::logger << util::begin_comment << "inf::Inflation::UseDistrSymmetries::"
                  << util::end_comment;
@@ -20,21 +29,41 @@ void inf::Inflation::log(inf::Inflation::UseDistrSymmetries use_distr_symmetries
     }
 }
 
+void inf::Inflation::log(inf::Inflation::PartyOrder party_order) {
+    util::logger << util::begin_comment << "inf::Inflation::PartyOrder::"
+                 << util::end_comment;
+    switch (party_order) {
+    case inf::Inflation::PartyOrder::standard:
+        util::logger << "standard";
+        break;
+    case inf::Inflation::PartyOrder::optimized:
+        util::logger << "optimized";
+        break;
+    default:
+        THROW_ERROR("switch")
+    }
+}
+
 // INFLATION
 
 inf::Inflation::Inflation(inf::TargetDistr::ConstPtr const &target_distr,
                           inf::Inflation::Size const &size,
-                          inf::Inflation::UseDistrSymmetries use_distr_symmetries)
+                          inf::Inflation::UseDistrSymmetries use_distr_symmetries,
+                          inf::Inflation::PartyOrder party_order,
+                          std::vector<std::vector<std::string>> const &constraint_marginals)
     : m_target_distr(target_distr),
       m_size(size),
       m_use_distr_symmetries(use_distr_symmetries),
+      m_party_order(party_order),
+      m_parties{},
       m_party_map{},
       m_name_map{},
       m_party_names{},
       m_source_induced_syms{},
       m_inflation_symmetries{},
       m_n_parties{},
-      m_symtree(nullptr),
+      m_symtree_flag(),
+      m_symtree_entry(nullptr),
       m_rng(0, m_target_distr->get_network()->get_outcome_last()) {
     Index number_of_sources = 3;
     HARD_ASSERT_EQUAL(size.size(), number_of_sources)
@@ -44,11 +73,14 @@ inf::Inflation::Inflation(inf::TargetDistr::ConstPtr const &target_distr,
         }
     }
     // This also initialize m_n_parties
-    init_parties();
+    init_parties(get_ordered_parties({0, 1, 2}, {0, 1, 2}));
     // Needs to be called before init_inflation_symmetries()
     init_source_induced_syms();
     // To intialize the applicable symmetries
     init_inflation_symmetries(m_target_distr->get_sym_group());
+
+    if (m_party_order == inf::Inflation::PartyOrder::optimized)
+        optimize_party_order(constraint_marginals);
 }
 
 std::string inf::Inflation::get_metadata() const {
@@ -68,9 +100,67 @@ std::string inf::Inflation::get_metadata() const {
     return ret;
 }
 
+std::string inf::Inflation::get_symtree_metadata() const {
+    HARD_ASSERT_EQUAL(m_size.size(), 3)
+
+    return "Network name: " + m_target_distr->get_network()->get_name() + "; " +
+           "Outcomes per party: " + util::str(static_cast<int>(m_target_distr->get_network()->get_n_outcomes())) + "; " +
+           "Inflation size: " + util::str(m_size[0]) + "x" + util::str(m_size[1]) + "x" + util::str(m_size[2]) + "; " +
+           "The inflation has " + util::str(m_inflation_symmetries.size()) + " symmetries; " +
+           (has_standard_party_order() ? "" : "Party order: " + get_party_order_str() + "; ") +
+           "Symmetry group hash: " + get_symtree_hash_str();
+}
+
+Index inf::Inflation::get_symtree_hash() const {
+    // 64-bit FNV-1a, applied to the bytes of each value in little-endian order
+    Index hash = 0xcbf29ce484222325;
+    auto const hash_value = [&hash](Index const value) {
+        for (Index byte : util::Range(sizeof(Index))) {
+            hash ^= (value >> (8 * byte)) & 0xff;
+            hash *= 0x100000001b3;
+        }
+    };
+
+    std::string const &network_name = m_target_distr->get_network()->get_name();
+    hash_value(network_name.size());
+    for (char const c : network_name)
+        hash_value(static_cast<unsigned char>(c));
+
+    hash_value(m_target_distr->get_network()->get_n_outcomes());
+
+    hash_value(m_size.size());
+    for (Index const n_copies : m_size)
+        hash_value(n_copies);
+
+    // The party indices below refer to this ordering, which we hash only if it is not the standard one to keep the standard hashes
+    if (not has_standard_party_order()) {
+        for (std::string const &party_name : m_party_names) {
+            hash_value(party_name.size());
+            for (char const c : party_name)
+                hash_value(static_cast<unsigned char>(c));
+        }
+    }
+
+    hash_value(m_inflation_symmetries.size());
+    for (inf::Symmetry const &sym : m_inflation_symmetries) {
+        for (Index const party : sym.get_party_sym().get_bare_sym())
+            hash_value(party);
+        for (inf::Outcome const outcome : sym.get_outcome_sym().get_bare_sym())
+            hash_value(outcome);
+    }
+
+    return hash;
+}
+
+std::string inf::Inflation::get_symtree_hash_str() const {
+    std::stringstream string_stream;
+    string_stream << std::hex << std::setw(2 * sizeof(Index)) << std::setfill('0') << get_symtree_hash();
+    return string_stream.str();
+}
+
 std::string inf::Inflation::get_symtree_filename() const {
     HARD_ASSERT_EQUAL(m_size.size(), 3)
-    return "data/symtree_" + m_target_distr->get_short_name() + "_" + util::str(m_size[0]) + util::str(m_size[1]) + util::str(m_size[2]);
+    return "data/symtree_" + util::str(m_size[0]) + util::str(m_size[1]) + util::str(m_size[2]) + "_" + get_symtree_hash_str();
 }
 
 void inf::Inflation::log() const {
@@ -78,9 +168,22 @@ void inf::Inflation::log() const {
 
     util::logger << get_metadata() << util::cr;
 
+    if (not has_standard_party_order())
+        util::logger << "Party order: " << get_party_order_str() << util::cr;
+
     LOG_END_SECTION
 }
 
+std::string inf::Inflation::get_party_order_str() const {
+    std::string ret = "";
+    for (Index const party : util::Range(m_n_parties)) {
+        if (party != 0)
+            ret += " ";
+        ret += get_party_name(party);
+    }
+    return ret;
+}
+
 void inf::Inflation::log_event(
     inf::Event const &event) const {
     ASSERT_EQUAL("Triangle network", m_target_distr->get_network()->get_name());
@@ -302,30 +405,98 @@ inf::PartySym inf::Inflation::network_party_to_inf_party_sym(
     return inf::PartySym(inf_sym);
 }
 
-inf::EventTree const &inf::Inflation::get_symtree(inf::EventTree::IO io) const {
-    if (m_symtree == nullptr) {
-        m_symtree = std::make_unique<inf::EventTree>(m_n_parties);
+std::map<std::string, std::weak_ptr<inf::Inflation::SymtreeEntry>> inf::Inflation::s_symtree_registry{};
+std::mutex inf::Inflation::s_symtree_registry_mutex{};
 
-        if (io == inf::EventTree::IO::read) {
-            util::logger << "Reading the symmetrized event tree..." << util::cr;
+inf::EventTree const &inf::Inflation::get_symtree(inf::EventTree::IO io, Index n_threads) const {
+    std::call_once(m_symtree_flag, [this, io, n_threads]() {
+        std::shared_ptr<inf::Inflation::SymtreeEntry> entry;
+        {
+            std::lock_guard<std::mutex> const lock(s_symtree_registry_mutex);
 
-            util::InputFileStream stream(get_symtree_filename(), util::FileStream::Format::text, get_metadata());
-            stream.io(*m_symtree);
-        } else {
-            util::logger << "Filling the symmetrized event tree..." << util::cr;
+            std::weak_ptr<inf::Inflation::SymtreeEntry> &registered_entry = s_symtree_registry[get_symtree_metadata()];
+            entry = registered_entry.lock();
+            if (entry == nullptr) {
+                entry = std::make_shared<inf::Inflation::SymtreeEntry>();
+                registered_entry = entry;
+            }
+
+            // Forget the entries that were freed in the meantime
+            for (auto it = s_symtree_registry.begin(); it != s_symtree_registry.end();) {
+                if (it->second.expired())
+                    it = s_symtree_registry.erase(it);
+                else
+                    ++it;
+            }
+        }
 
-            inf::TreeFiller::fill_tree(*m_symtree, *this);
+        // The other inf::Inflation asking for the same inf::EventTree wait here until it is loaded, and retry if loading it throws
+        bool loaded_here = false;
+        std::call_once(entry->load_flag, [this, io, n_threads, &entry, &loaded_here]() {
+            entry->symtree = load_symtree(io, n_threads);
+            loaded_here = true;
+        });
+        if (not loaded_here) {
+            util::logger << "Sharing the symmetrized event tree of another inf::Inflation." << util::cr;
 
+            // The inf::Inflation that loaded the inf::EventTree may not have saved it, in which case we do
             if (io == inf::EventTree::IO::write) {
-                util::logger << "Saving the symmetrized event tree..." << util::cr;
-
-                util::OutputFileStream stream(get_symtree_filename(), util::FileStream::Format::text, get_metadata());
-                stream.io(*m_symtree);
+                std::call_once(entry->save_flag, [this, &entry]() {
+                    if (not util::FileStream::exists(get_symtree_filename(), util::FileStream::Format::text) or
+                        not inf::EventTree::image_exists(get_symtree_filename()))
+                        save_symtree(*entry->symtree);
+                });
             }
         }
+
+        m_symtree_entry = entry;
+    });
+
+    return *m_symtree_entry->symtree;
+}
+
+inf::EventTree::ConstPtr inf::Inflation::load_symtree(inf::EventTree::IO io, Index n_threads) const {
+    inf::EventTree::UniquePtr symtree = std::make_unique<inf::EventTree>(m_n_parties);
+
+    if (io == inf::EventTree::IO::read) {
+        util::logger << "Reading the symmetrized event tree..." << util::cr;
+
+        // The binary image is mapped into memory without parsing, so we prefer it when it exists
+        if (inf::EventTree::image_exists(get_symtree_filename())) {
+            symtree->read_image(get_symtree_filename(), get_symtree_metadata());
+        } else {
+            util::InputFileStream stream(get_symtree_filename(), util::FileStream::Format::text, get_symtree_metadata());
+            stream.io(*symtree);
+        }
+    } else {
+        util::logger << "Filling the symmetrized event tree..." << util::cr;
+
+        if (io == inf::EventTree::IO::write) {
+            // Long fillings are checkpointed, so that they can be resumed if the process is interrupted
+            std::string const checkpoint_filename = get_symtree_filename() + "_checkpoint";
+            inf::TreeFiller::fill_tree(*symtree, *this, n_threads, checkpoint_filename);
+
+            save_symtree(*symtree);
+
+            inf::TreeFiller::remove_checkpoint(checkpoint_filename);
+        } else {
+            inf::TreeFiller::fill_tree(*symtree, *this, n_threads);
+        }
     }
 
-    return *m_symtree;
+    return symtree;
+}
+
+void inf::Inflation::save_symtree(inf::EventTree const &symtree) const {
+    util::logger << "Saving the symmetrized event tree..." << util::cr;
+
+    {
+        util::OutputFileStream stream(get_symtree_filename(), util::FileStream::Format::text, get_symtree_metadata());
+        // util::FileStream::io() both reads and writes, but writing leaves symtree unchanged
+        stream.io(const_cast<inf::EventTree &>(symtree));
+    }
+
+    symtree.write_image(get_symtree_filename(), get_symtree_metadata());
 }
 
 bool inf::Inflation::are_d_separated(std::vector<Index> const &marg_1,
@@ -385,7 +556,11 @@ bool inf::Inflation::is_injectable_set(std::vector<Index> const &marg) const {
 
 // Private methods
 
-void inf::Inflation::init_parties() {
+std::vector<inf::Inflation::Party> inf::Inflation::get_ordered_parties(std::vector<Index> const &source_order,
+                                                                      std::vector<Index> const &network_party_order) const {
+    HARD_ASSERT_EQUAL(source_order.size(), 3)
+    HARD_ASSERT_EQUAL(network_party_order.size(), 3)
+
     // First, the inflation size steps
 
     std::vector<inf::Inflation::Size> inf_size_steps = {{1, 1, 1}};
@@ -395,7 +570,7 @@ void inf::Inflation::init_parties() {
         // Copy here
         inf::Inflation::Size current_inf_size = inf_size_steps.back();
 
-        for (Index source_i : util::Range(final_inf_size.size())) {
+        for (Index source_i : source_order) {
             if (current_inf_size[source_i] < final_inf_size[source_i]) {
                 current_inf_size[source_i] += 1;
                 inf_size_steps.push_back(current_inf_size);
@@ -403,29 +578,43 @@ void inf::Inflation::init_parties() {
         }
     }
 
-    Index party_index = 0;
+    std::vector<inf::Inflation::Party> parties;
+    std::set<inf::Inflation::Party> listed_parties;
     for (inf::Inflation::Size const &inf_size : inf_size_steps) {
         for (inf::Inflation::Sources const &sources : util::ProductRange(inf_size)) {
-            for (Index network_party_i : this->get_network()->get_party_range()) {
+            for (Index network_party_i : network_party_order) {
                 Index left = sources[(network_party_i + 1) % 3];
                 Index right = sources[(network_party_i + 2) % 3];
 
                 inf::Inflation::Party party(network_party_i, {left, right});
 
-                if (not m_party_map.contains(party)) {
-                    m_party_map[party] = party_index;
-                    m_parties.push_back(party);
-
-                    std::string name = m_target_distr->get_network()->get_party_names()[network_party_i] + util::str(left) + util::str(right);
-                    m_name_map[name] = party_index;
-                    m_party_names.push_back(name);
-
-                    ++party_index;
-                }
+                if (listed_parties.insert(party).second)
+                    parties.push_back(party);
             }
         }
     }
 
+    return parties;
+}
+
+void inf::Inflation::init_parties(std::vector<inf::Inflation::Party> const &parties) {
+    m_parties.clear();
+    m_party_map.clear();
+    m_name_map.clear();
+    m_party_names.clear();
+
+    Index party_index = 0;
+    for (inf::Inflation::Party const &party : parties) {
+        m_party_map[party] = party_index;
+        m_parties.push_back(party);
+
+        std::string name = m_target_distr->get_network()->get_party_names()[party.first] + util::str(party.second[0]) + util::str(party.second[1]);
+        m_name_map[name] = party_index;
+        m_party_names.push_back(name);
+
+        ++party_index;
+    }
+
     m_n_parties = party_index;
 
     ASSERT_EQUAL(party_index, get_n_parties())
@@ -434,6 +623,165 @@ void inf::Inflation::init_parties() {
     ASSERT_EQUAL(m_party_names.size(), get_n_parties())
 }
 
+bool inf::Inflation::has_standard_party_order() const {
+    return m_parties == get_ordered_parties({0, 1, 2}, {0, 1, 2});
+}
+
+void inf::Inflation::optimize_party_order(std::vector<std::vector<std::string>> const &constraint_marginals) {
+    // Each constraint marginal is the union of the inflation marginals of its description
+    std::vector<std::vector<Index>> marginals;
+    for (std::vector<std::string> const &description : constraint_marginals) {
+        std::vector<Index> marginal;
+        for (std::string const &inf_marg_name : description) {
+            for (Index const party : inf::ConstraintParser::parse_inflation_marginal(*this, inf_marg_name))
+                marginal.push_back(party);
+        }
+        if (marginal.size() > 0)
+            marginals.push_back(marginal);
+    }
+
+    // The candidates are scored in terms of the party indices of the standard ordering, which is the current one
+    std::vector<Index> position(m_n_parties, 0);
+    for (Index const party : util::Range(m_n_parties))
+        position[party] = party;
+
+    std::vector<inf::Inflation::Party> best_parties = m_parties;
+    std::pair<Index, double> best_score = get_party_order_score(position, marginals);
+
+    // The candidates: the standard-like orderings, and the greedy ordering
+    std::vector<std::vector<inf::Inflation::Party>> candidates;
+    Index const n_network_parties = 3;
+    for (std::vector<Index> const &source_order : util::Permutations(n_network_parties)) {
+        for (std::vector<Index> const &network_party_order : util::Permutations(n_network_parties))
+            candidates.push_back(get_ordered_parties(source_order, network_party_order));
+    }
+    candidates.push_back(get_greedy_parties(marginals));
+
+    for (std::vector<inf::Inflation::Party> const &parties : candidates) {
+        for (Index const depth : util::Range(m_n_parties))
+            position[get_party_index(parties[depth])] = depth;
+
+        std::pair<Index, double> const score = get_party_order_score(position, marginals);
+        if (score < best_score) {
+            best_score = score;
+            best_parties = parties;
+        }
+    }
+
+    if (best_parties != m_parties) {
+        init_parties(best_parties);
+
+        // The symmetries act on party indices, so they have to be recomputed
+        m_source_induced_syms.clear();
+        m_inflation_symmetries.clear();
+        init_source_induced_syms();
+        init_inflation_symmetries(m_target_distr->get_sym_group());
+    }
+}
+
+std::vector<inf::Inflation::Party> inf::Inflation::get_greedy_parties(std::vector<std::vector<Index>> const &marginals) const {
+    // The distinct images of the marginals under the inflation symmetries, as sets of parties
+    std::set<std::vector<Index>> image_set;
+    for (inf::Symmetry const &sym : m_inflation_symmetries) {
+        inf::PartySym::Bare const &party_sym = sym.get_party_sym().get_bare_sym();
+
+        for (std::vector<Index> const &marginal : marginals) {
+            std::vector<Index> image;
+            for (Index const party : marginal)
+                image.push_back(party_sym[party]);
+            std::sort(image.begin(), image.end());
+            image_set.insert(image);
+        }
+    }
+    std::vector<std::vector<Index>> const images(image_set.begin(), image_set.end());
+
+    // n_unplaced[i] is the number of parties of images[i] that are not yet in the ordering
+    std::vector<Index> n_unplaced;
+    std::vector<std::vector<Index>> party_to_images(m_n_parties);
+    for (Index const image_i : util::Range(images.size())) {
+        n_unplaced.push_back(images[image_i].size());
+        for (Index const party : images[image_i])
+            party_to_images[party].push_back(image_i);
+    }
+
+    std::vector<inf::Inflation::Party> parties;
+    std::vector<bool> is_placed(m_n_parties, false);
+    for (Index const depth : util::Range(m_n_parties)) {
+        (void)depth;
+
+        // We first maximize the number of images that get completed, then the progress made on the other images.
+        // Ties are resolved with the current ordering.
+        Index best_party = m_n_parties;
+        std::pair<Index, double> best_gain(0, 0.0);
+        for (Index const party : util::Range(m_n_parties)) {
+            if (is_placed[party])
+                continue;
+
+            std::pair<Index, double> gain(0, 0.0);
+            for (Index const image_i : party_to_images[party]) {
+                if (n_unplaced[image_i] == 1)
+                    ++gain.first;
+                else
+                    gain.second += 1.0 / static_cast<double>(n_unplaced[image_i]);
+            }
+
+            if (best_party == m_n_parties or gain > best_gain) {
+                best_party = party;
+                best_gain = gain;
+            }
+        }
+
+        is_placed[best_party] = true;
+        for (Index const image_i : party_to_images[best_party])
+            --n_unplaced[image_i];
+        parties.push_back(m_parties[best_party]);
+    }
+
+    return parties;
+}
+
+std::pair<Index, double> inf::Inflation::get_party_order_score(std::vector<Index> const &position,
+                                                                std::vector<std::vector<Index>> const &marginals) const {
+    ASSERT_EQUAL(position.size(), m_n_parties)
+
+    // n_stabilizing[d] counts the symmetries that leave the first d + 1 parties invariant as a set
+    std::vector<Index> n_stabilizing(m_n_parties, 0);
+    Index marginal_score = 0;
+
+    std::vector<Index> party_at(m_n_parties, 0);
+    for (Index const party : util::Range(m_n_parties))
+        party_at[position[party]] = party;
+
+    for (inf::Symmetry const &sym : m_inflation_symmetries) {
+        inf::PartySym::Bare const &party_sym = sym.get_party_sym().get_bare_sym();
+
+        // The first d + 1 parties are left invariant if and only if their images all have a depth at most d
+        Index max_image_depth = 0;
+        for (Index const depth : util::Range(m_n_parties)) {
+            max_image_depth = std::max(max_image_depth, position[party_sym[party_at[depth]]]);
+            if (max_image_depth == depth)
+                ++n_stabilizing[depth];
+        }
+
+        for (std::vector<Index> const &marginal : marginals) {
+            Index completion_depth = 0;
+            for (Index const party : marginal)
+                completion_depth = std::max(completion_depth, position[party_sym[party]]);
+            marginal_score += completion_depth;
+        }
+    }
+
+    double const n_outcomes = static_cast<double>(m_target_distr->get_network()->get_n_outcomes());
+    double predicted_n_nodes = 0.0;
+    double n_prefixes = 1.0;
+    for (Index const depth : util::Range(m_n_parties)) {
+        n_prefixes *= n_outcomes;
+        predicted_n_nodes += n_prefixes / static_cast<double>(n_stabilizing[depth]);
+    }
+
+    return {marginal_score, predicted_n_nodes};
+}
+
 void inf::Inflation::init_source_induced_syms() {
     ASSERT_EQUAL(m_source_induced_syms.size(), 0)
 
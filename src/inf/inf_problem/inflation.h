@@ -4,6 +4,9 @@
 #include "../events/event_tree.h"
 #include "target_distr.h"
 
+#include <map>
+#include <mutex>
+
 /*! \file */
 
 /*! \defgroup inflation Inflation
@@ -43,9 +46,14 @@ namespace inf {
     of the party \f$f(0)\f$, then \f$f(1)\f$, etc, the order potentially has an impact on the runtime once we add the branch-and-bound
     mechanism (see inf::DualVector::StoreBounds).
 
-    The ordering that we choose in inf::Inflation::init_parties() is thought (though, not tested) to be good because it enumerates the parties
+    The ordering that we choose in inf::Inflation::get_ordered_parties() is thought (though, not tested) to be good because it enumerates the parties
     in a way where the volume of the cube (in the cube representation of triangle network strategies/inflation events) is attempted to be
     maximized early on.
+
+    With inf::Inflation::PartyOrder::optimized, the inf::Inflation instead compares several such orderings (growing the sources and
+    enumerating the network parties in different orders), as well as a greedy ordering that completes the constraint marginals early,
+    and keeps the best one, see inf::Inflation::get_party_order_score().
+    Everything else refers to the parties by their index or by their name, so that this is transparent to the rest of the code.
     */
 
 class Inflation : public util::Loggable {
@@ -87,16 +95,31 @@ class Inflation : public util::Loggable {
 
     static void log(inf::Inflation::UseDistrSymmetries use_distr_symmetries);
 
+    /*! \brief How the inflation parties are ordered, which is also the order in which inf::TreeFiller and inf::TreeOpt fill their outcomes
+        \details See the "Party ordering" section of inf::Inflation. The ordering does not change the mathematical problem, only the size of
+        the inf::EventTree and how early the inf::Marginal of the constraints are fully determined during the tree search of inf::TreeOpt. */
+    enum class PartyOrder {
+        standard, ///< The ordering described in the "Party ordering" section of inf::Inflation
+        optimized ///< The ordering with the best inf::Inflation::get_party_order_score()
+    };
+
+    static void log(inf::Inflation::PartyOrder party_order);
+
     /*! \brief Constructor with number of copies of each source
         \param target_distr Yields the inf::Network and the relevant symmetries. It is stored to keep track of its symmetries and
         to have an adequate name to write as metadata in the output file of the corresponding inf::EventTree (see inf::Inflation::get_symtree())
         \param size We consider inflations indexed by an inflation size \f$\infsize = (\infsize_1,\infsize_2,\infsize_3) \in \N^3\f$,
         where \f$\infsize_\type \geq 1\f$ denotes the number of copies of the source of type \f$\type\f$ (where \f$\type=0\f$ means the \f$\alpha\f$ source,
     \f$\type=1\f$ means the \f$\beta\f$ source, and \f$\type=2\f$ means the \f$\gamma\f$ source).
-        \param use_distr_symmetries Whether or not the distribution symmetries will be incorporated in the inflation symmetry group. See inf::Inflation::UseDistrSymmetries for more details. */
+        \param use_distr_symmetries Whether or not the distribution symmetries will be incorporated in the inflation symmetry group. See inf::Inflation::UseDistrSymmetries for more details.
+        \param party_order How to order the inflation parties, see inf::Inflation::PartyOrder.
+        \param constraint_marginals Only used with inf::Inflation::PartyOrder::optimized: the inflation marginals of the constraints that will be imposed,
+        each given as a list of strings of comma-separated party names (as in inf::ConstraintSet::Description), so that the ordering can complete them early. */
     Inflation(inf::TargetDistr::ConstPtr const &target_distr,
               inf::Inflation::Size const &size,
-              inf::Inflation::UseDistrSymmetries use_distr_symmetries = inf::Inflation::UseDistrSymmetries::yes);
+              inf::Inflation::UseDistrSymmetries use_distr_symmetries = inf::Inflation::UseDistrSymmetries::yes,
+              inf::Inflation::PartyOrder party_order = inf::Inflation::PartyOrder::standard,
+              std::vector<std::vector<std::string>> const &constraint_marginals = {});
 
     //! \cond
     Inflation(inf::Inflation const &other) = delete;
@@ -109,10 +132,23 @@ class Inflation : public util::Loggable {
 
     /*! \brief A string that summarizes the main information about the inf::Inflation, its symmetries and whether or not
      * these include the symmetries of an inf::TargetDistr, the name of the underlying inf::TargetDistr, etc.
-     * \details This is used when writing the inf::EventTree to be sure to read from the correct file.
-     * See inf::Inflation::get_symtree(). */
+     * \details This is used when writing files that depend on the inf::TargetDistr, such as the dual vectors written by
+     * inf::ConstraintSet. The inf::EventTree files use inf::Inflation::get_symtree_metadata() instead. */
     std::string get_metadata() const;
-    /*! \brief The filename to which the inf::EventTree is stored, including the inflation size and the short name of the inf::TargetDistr used for symmetry accelaration */
+    /*! \brief A string that summarizes what the symmetrized events depend on, i.e., the inf::Network, the inflation size and the inflation symmetries
+     * \details Contrary to inf::Inflation::get_metadata(), this does not mention the inf::TargetDistr, so that all the
+     * inf::TargetDistr with the same symmetries share the same inf::EventTree.
+     * This is used when writing the inf::EventTree to be sure to read from the correct file. See inf::Inflation::get_symtree(). */
+    std::string get_symtree_metadata() const;
+    /*! \brief A canonical hash of the inf::Network, the number of outcomes, the inflation size and the inflation symmetry group
+     * \details The symmetry group is hashed in the order of inf::Symmetry::Group, which does not depend on how it was generated.
+     * The hash function is fixed (rather than `std::hash`), so that the hash does not depend on the platform or the compiler. */
+    Index get_symtree_hash() const;
+    /*! \brief inf::Inflation::get_symtree_hash() as exactly 16 hexadecimal digits, padded with leading zeros */
+    std::string get_symtree_hash_str() const;
+    /*! \brief The filename to which the inf::EventTree is stored, which includes the inflation size and inf::Inflation::get_symtree_hash()
+     * \details The inf::EventTree files are thus content-addressed: any two inf::Inflation with the same symmetrized events
+     * (e.g., for different inf::TargetDistr with the same symmetries) use the same file. */
     std::string get_symtree_filename() const;
     void log() const override;
     /*! \brief To print inflation events \f$\infevent \in \infevents\f$ to `util::logger` */
@@ -193,16 +229,23 @@ class Inflation : public util::Loggable {
      * \details The set \f$\redinfevents\f$ depends on the symmetry group that is being used: this includes or does not include
      * the inf::TargetDistr (passed to the constructor) symmetries, see inf::Inflation::UseDistrSymmetries for more details.
      *
-     * On the first call to this method, `m_symtree` is initialized and then cached.
-     * How `m_symtree` is initialized depends on the parameter \p io: if \p io is inf::EventTree::IO::read,
+     * On the first call to this method, `m_symtree_entry` is initialized and then cached, even if several threads call this method concurrently.
+     * The inf::EventTree is shared by all the inf::Inflation of the process that have the same inf::Inflation::get_symtree_metadata():
+     * if one of them already holds it or is loading it, `m_symtree_entry` just points to it (see `s_symtree_registry`).
+     * In that case, \p io only matters if it is inf::EventTree::IO::write: the shared inf::EventTree is then saved as described below,
+     * unless both of its files already exist.
+     * Otherwise, how the inf::EventTree is initialized depends on the parameter \p io: if \p io is inf::EventTree::IO::read,
      * then the inf::Inflation reads the inf::EventTree from the file inf::Inflation::get_symtree_filename().
-     * Else, it computes the inf::EventTree using the class inf::TreeFiller.
+     * The binary image (see inf::EventTree::read_image()) is used if it exists, and the text file otherwise.
+     * Else, it computes the inf::EventTree using the class inf::TreeFiller with \p n_threads threads.
      * If \p io is inf::EventTree::IO::write, the inf::Inflation furthermore saves the resulting inf::EventTree
-     * to the file inf::Inflation::get_symtree_filename().
+     * to the file inf::Inflation::get_symtree_filename(), both as a text file and as a binary image.
+     * In that case, the filling is also checkpointed to the file inf::Inflation::get_symtree_filename() followed by `_checkpoint`,
+     * and resumes from that checkpoint if it exists (see inf::TreeFiller); the checkpoint is deleted once the inf::EventTree is saved.
      *
      * In practice, the inf::EventTree::IO parameter will come from the `--symtree-io` command-line parameter,
      * see \ref CLIparams the "command-line parameter documentation" for more information. */
-    inf::EventTree const &get_symtree(inf::EventTree::IO io) const;
+    inf::EventTree const &get_symtree(inf::EventTree::IO io, Index n_threads = 1) const;
 
     // For inflation constraints
 
@@ -229,6 +272,8 @@ class Inflation : public util::Loggable {
     inf::Inflation::Size const m_size;
     /*! \brief Whether or not the distribution symmetries were incorporated in the inflation symmetry group, see inf::Inflation::UseDistrSymmetries */
     inf::Inflation::UseDistrSymmetries const m_use_distr_symmetries;
+    /*! \brief Whether the inflation parties are ordered in the standard way or in an optimized way, see inf::Inflation::PartyOrder */
+    inf::Inflation::PartyOrder const m_party_order;
 
     /*! \brief The list of explicit inf::Inflation::Parties, this is the inverse of `m_party_map` */
     std::vector<inf::Inflation::Party> m_parties;
@@ -238,8 +283,33 @@ class Inflation : public util::Loggable {
     std::map<std::string, Index> m_name_map;
     /*! \brief This list is used in `inf::Inflation::get_party_name()` */
     std::vector<std::string> m_party_names;
-    /*! \brief This initializes `m_parties`, `m_party_map`, `m_name_map`, `m_party_names` */
-    void init_parties();
+    /*! \brief This initializes `m_parties`, `m_party_map`, `m_name_map`, `m_party_names` from the list \p parties */
+    void init_parties(std::vector<inf::Inflation::Party> const &parties);
+    /*! \brief Lists the inflation parties by growing the inflation one source copy at a time, as explained in the "Party ordering" section of inf::Inflation
+        \param source_order The order in which the sources get a new copy at each step; the standard ordering uses `{0,1,2}`
+        \param network_party_order The order in which the network parties are enumerated for each new set of source copies; the standard ordering uses `{0,1,2}` */
+    std::vector<inf::Inflation::Party> get_ordered_parties(std::vector<Index> const &source_order,
+                                                           std::vector<Index> const &network_party_order) const;
+    /*! \brief The names of the inflation parties in the order of their indices, e.g., "A00 B00 C00 ..." */
+    std::string get_party_order_str() const;
+    /*! \brief Returns `true` if the parties are ordered as with inf::Inflation::PartyOrder::standard */
+    bool has_standard_party_order() const;
+    /*! \brief Reorders the inflation parties according to the candidate with the best inf::Inflation::get_party_order_score(),
+        and recomputes the symmetries accordingly
+        \param constraint_marginals See the constructor inf::Inflation::Inflation() */
+    void optimize_party_order(std::vector<std::vector<std::string>> const &constraint_marginals);
+    /*! \brief Orders the parties greedily so as to complete the images of the \p marginals under the inflation symmetries as early as possible
+        \param marginals Party indices (of the current ordering) of the constraint marginals */
+    std::vector<inf::Inflation::Party> get_greedy_parties(std::vector<std::vector<Index>> const &marginals) const;
+    /*! \brief Scores a candidate ordering of the parties, lower is better
+        \details The first component sums, over the inflation symmetries and the \p marginals, the depth at which the image of the marginal
+        is fully determined: the earlier this happens, the earlier inf::TreeOpt can prune. The second component predicts the number of nodes
+        of the inf::EventTree: at depth \f$d\f$, we count \f$n^d / |H_d|\f$ nodes, where \f$n\f$ is the number of outcomes and \f$H_d\f$ is the subgroup
+        of the inflation symmetries that leave the first \f$d\f$ parties invariant (as a set).
+        \param position `position[party]` is the depth of `party` (a party index of the current ordering) in the candidate ordering
+        \param marginals Party indices (of the current ordering) of the constraint marginals */
+    std::pair<Index, double> get_party_order_score(std::vector<Index> const &position,
+                                                   std::vector<std::vector<Index>> const &marginals) const;
 
     /*! \brief The inflation party symmetries coming from source relabelings */
     std::vector<inf::PartySym> m_source_induced_syms;
@@ -263,10 +333,35 @@ class Inflation : public util::Loggable {
     /*! \brief The number \f$|\infparties|\f$ of parties of the inflation */
     Index m_n_parties;
 
+    /*! \brief An entry of `s_symtree_registry`, which holds the inf::EventTree of one inf::Inflation::get_symtree_metadata() once it is loaded */
+    struct SymtreeEntry {
+        /*! \brief Ensures that the inf::EventTree is loaded once, by the first inf::Inflation asking for it */
+        std::once_flag load_flag;
+        /*! \brief The symmetrized inflation events, which is `nullptr` until they are loaded, see inf::Inflation::load_symtree() */
+        inf::EventTree::ConstPtr symtree;
+        /*! \brief Ensures that the inf::Inflation sharing the inf::EventTree save it at most once, see inf::Inflation::get_symtree() */
+        std::once_flag save_flag;
+    };
+
+    /*! \brief Ensures that `m_symtree_entry` is initialized once, even if inf::Inflation::get_symtree() is called concurrently */
+    mutable std::once_flag m_symtree_flag;
     /*! \brief Stores the symmetrized inflation events as a tree, see inf::Inflation::get_symtree()
      * \details This is a `mutable` member because the caching mechanism requires initializing the event tree
-     * on `const inf::Inflation` instances. */
-    mutable inf::EventTree::UniquePtr m_symtree;
+     * on `const inf::Inflation` instances. The entry is shared with the other inf::Inflation that use it, see `s_symtree_registry`. */
+    mutable std::shared_ptr<inf::Inflation::SymtreeEntry> m_symtree_entry;
+    /*! \brief Reads or fills the inf::EventTree returned by inf::Inflation::get_symtree(), see there for the meaning of \p io and \p n_threads */
+    inf::EventTree::ConstPtr load_symtree(inf::EventTree::IO io, Index n_threads) const;
+    /*! \brief Writes \p symtree to the file inf::Inflation::get_symtree_filename(), both as a text file and as a binary image */
+    void save_symtree(inf::EventTree const &symtree) const;
+
+    /*! \brief The inf::EventTree currently in use in the process, indexed by inf::Inflation::get_symtree_metadata()
+     * \details The registry only holds weak references: an entry, and hence its inf::EventTree, is freed when the last inf::Inflation using it is destroyed.
+     * This way, several inf::FeasProblem with the same symmetrized events (e.g., in a parallel scan) hold a single copy of the inf::EventTree. */
+    static std::map<std::string, std::weak_ptr<inf::Inflation::SymtreeEntry>> s_symtree_registry;
+    /*! \brief Protects `s_symtree_registry`
+     * \details This is only held while looking up an entry, the inf::EventTree being then loaded under inf::Inflation::SymtreeEntry::load_flag,
+     * so that loading an inf::EventTree does not hold back the inf::Inflation that use another one. */
+    static std::mutex s_symtree_registry_mutex;
 
     /*! \brief Used for inf::Inflation::get_random_event()
         \details This is a `mutable` member since, conceptually, inf::Inflation::get_random_event() does not
@@ -1,24 +1,45 @@
 #include "tree_filler.h"
 #include "../../util/debug.h"
 #include "../../util/logger.h"
+#include "../../util/file_stream.h"
+// For std::rename and std::remove
+#include <cstdio>
+#include <future>
 
-void inf::TreeFiller::fill_tree(inf::EventTree &tree, inf::Inflation const &inflation) {
-    inf::TreeFiller TreeFiller(tree, inflation);
+// Enough prefixes for the threads to even out the work, but few enough to keep the merging cheap
+Index const inf::TreeFiller::target_prefixes_per_thread = 16;
+Index const inf::TreeFiller::target_batches_with_checkpoints = 16;
+// Ten minutes
+double const inf::TreeFiller::default_checkpoint_period = 600.0;
+
+void inf::TreeFiller::fill_tree(inf::EventTree &tree,
+                                inf::Inflation const &inflation,
+                                Index n_threads,
+                                std::string const &checkpoint_filename,
+                                double checkpoint_period) {
+    inf::TreeFiller TreeFiller(tree, inflation, n_threads, checkpoint_filename, checkpoint_period);
+}
+
+void inf::TreeFiller::remove_checkpoint(std::string const &checkpoint_filename) {
+    std::remove((checkpoint_filename + util::FileStream::get_extension(util::FileStream::Format::text)).c_str());
 }
 
 inf::TreeFiller::TreeFiller(inf::EventTree &tree,
-                            inf::Inflation const &inflation)
-    : m_sym_chrono(util::Chrono::State::paused),
-      m_node_chrono(util::Chrono::State::paused),
-      m_tree(tree),
+                            inf::Inflation const &inflation,
+                            Index n_threads,
+                            std::string const &checkpoint_filename,
+                            double checkpoint_period)
+    : m_tree(tree),
       m_inflation(inflation),
+      m_checkpoint_filename(checkpoint_filename),
+      m_checkpoint_period(checkpoint_period),
       m_inflation_inverse_party_symmetries(),
       m_inflation_outcome_symmetries(),
       m_inflation_n_parties(inflation.get_n_parties()),
       m_unknown_outcome(inflation.get_network()->get_outcome_unknown()),
-      m_n_outcomes(inflation.get_network()->get_n_outcomes()),
-      m_working_event(inflation.get_all_unknown_event()),
-      m_current_syms(inflation.get_n_parties()) {
+      m_n_outcomes(inflation.get_network()->get_n_outcomes()) {
+    HARD_ASSERT_LT(0, n_threads)
+
     // Initialize the flattened symmetries
     {
         // vector rather than set
@@ -31,156 +52,461 @@ inf::TreeFiller::TreeFiller(inf::EventTree &tree,
         }
         ASSERT_EQUAL(m_inflation_inverse_party_symmetries.size(), m_inflation.get_inflation_symmetries().size())
         ASSERT_EQUAL(m_inflation_outcome_symmetries.size(), m_inflation.get_inflation_symmetries().size())
-
-        m_current_syms[0] = std::vector<Index>(m_inflation.get_inflation_symmetries().size());
-        for (Index i : util::Range(m_inflation.get_inflation_symmetries().size())) {
-            m_current_syms[0][i] = i;
-        }
     }
 
+    // With a single party, there is nothing to split
+    if ((n_threads == 1 and m_checkpoint_filename.empty()) or m_inflation_n_parties == 1)
+        fill_sequentially();
+    else
+        fill_by_prefixes(n_threads);
+
+    ASSERT_LT(0, m_tree.get_root_children_count())
+}
+
+void inf::TreeFiller::fill_sequentially() {
+    inf::TreeFiller::Worker worker(*this, m_tree);
+
     util::Chrono total_symtree_chrono(util::Chrono::State::running);
-    std::vector<Index> root_children = this->find_children(0);
+    std::vector<Index> root_children = worker.find_children(0);
     (void)root_children;
     total_symtree_chrono.pause();
 
     m_tree.finish_initialization();
 
-    ASSERT_LT(0, m_tree.get_root_children_count())
-
     // LOGGING
     {
         LOG_BEGIN_SECTION("inf::TreeFiller timing")
         util::logger
             << util::begin_comment << "Event symmetrization: " << util::end_comment
-            << m_sym_chrono << util::cr
+            << worker.sym_chrono << util::cr
             << util::begin_comment << "Node insertion in cache: " << util::end_comment
-            << m_node_chrono << util::cr
+            << worker.node_chrono << util::cr
             << util::begin_comment << "Total: " << util::end_comment
             << total_symtree_chrono << util::cr;
         LOG_END_SECTION
     }
 }
 
-std::vector<Index> inf::TreeFiller::find_children(Index depth) {
-    ASSERT_LT(depth, m_inflation_n_parties)
-    ASSERT_EQUAL(m_working_event[depth], m_unknown_outcome)
+void inf::TreeFiller::fill_by_prefixes(Index n_threads) {
+    util::Chrono total_symtree_chrono(util::Chrono::State::running);
+
+    bool const with_checkpoints = not m_checkpoint_filename.empty();
+    Index const batch_size = target_prefixes_per_thread * n_threads;
+
+    // This worker takes care of the prefixes and of the final assembly
+    inf::TreeFiller::Worker main_worker(*this, m_tree);
+
+    Index split_depth = 0;
+    std::vector<inf::TreeFiller::Prefix> prefixes;
+    if (with_checkpoints and util::FileStream::exists(m_checkpoint_filename, util::FileStream::Format::text)) {
+        util::logger << "Resuming the symmetrized event tree from a checkpoint..." << util::cr;
+        read_checkpoint(main_worker, split_depth, prefixes);
+    } else {
+        // Find the smallest split depth that gives enough prefixes for the threads to share the work.
+        // The split depth is at most the last depth, so that each prefix has at least one outcome left to fill.
+        Index const target_n_prefixes = batch_size * (with_checkpoints ? target_batches_with_checkpoints : 1);
+        while (split_depth < m_inflation_n_parties - 1 and prefixes.size() < target_n_prefixes) {
+            ++split_depth;
+            prefixes.clear();
+            main_worker.collect_prefixes(0, split_depth, prefixes);
+        }
+    }
+
+    std::vector<Index> remaining_prefixes;
+    for (Index prefix_index : util::Range(prefixes.size())) {
+        if (not prefixes[prefix_index].is_done)
+            remaining_prefixes.push_back(prefix_index);
+    }
+    Index const n_resumed_prefixes = prefixes.size() - remaining_prefixes.size();
+
+    std::vector<std::unique_ptr<inf::TreeFiller::Worker>> thread_workers;
+    thread_workers.reserve(n_threads);
+    for (Index thread_index : util::Range(n_threads)) {
+        (void)thread_index;
+        // The inf::EventTree is set for each batch
+        thread_workers.push_back(std::make_unique<inf::TreeFiller::Worker>(*this, m_tree));
+    }
+
+    util::Chrono parallel_chrono(util::Chrono::State::paused);
+    util::Chrono merge_chrono(util::Chrono::State::paused);
+    util::Chrono checkpoint_chrono(util::Chrono::State::paused);
+    util::Chrono since_checkpoint_chrono(util::Chrono::State::running);
+
+    // Without checkpoints, all the prefixes form a single batch
+    Index const n_prefixes_per_batch = with_checkpoints ? batch_size : remaining_prefixes.size();
+    for (Index batch_begin = 0; batch_begin < remaining_prefixes.size(); batch_begin += n_prefixes_per_batch) {
+        std::vector<Index> const batch(remaining_prefixes.begin() + static_cast<std::ptrdiff_t>(batch_begin),
+                                       remaining_prefixes.begin() + static_cast<std::ptrdiff_t>(
+                                                                        std::min(batch_begin + n_prefixes_per_batch,
+                                                                                 remaining_prefixes.size())));
+
+        // Each thread fills the subtrees of the prefixes it takes in its own inf::EventTree
+        parallel_chrono.start();
+        std::vector<std::unique_ptr<inf::EventTree>> thread_trees;
+        thread_trees.reserve(n_threads);
+        for (Index thread_index : util::Range(n_threads)) {
+            thread_trees.push_back(std::make_unique<inf::EventTree>(m_inflation_n_parties));
+            thread_workers[thread_index]->set_tree(*thread_trees.back());
+        }
+
+        std::atomic<Index> next_prefix(0);
+        std::vector<std::future<void>> futures;
+        futures.reserve(n_threads);
+        for (Index thread_index : util::Range(n_threads)) {
+            futures.push_back(std::async(std::launch::async,
+                                         &inf::TreeFiller::Worker::fill_prefixes,
+                                         thread_workers[thread_index].get(),
+                                         std::ref(prefixes),
+                                         std::cref(batch),
+                                         split_depth,
+                                         std::ref(next_prefix),
+                                         thread_index));
+        }
+        for (std::future<void> &future : futures)
+            future.get();
+        parallel_chrono.pause();
+
+        // Merge the nodes of each thread into the shared inf::EventTree, and translate the children of the prefixes accordingly
+        merge_chrono.start();
+        std::vector<std::vector<Index>> split_depth_indices(n_threads);
+        for (Index thread_index : util::Range(n_threads)) {
+            split_depth_indices[thread_index] = std::move(m_tree.merge_nodes(*thread_trees[thread_index])[split_depth]);
+            // The nodes are now in m_tree
+            thread_trees[thread_index].reset();
+        }
+        for (Index const prefix_index : batch) {
+            inf::TreeFiller::Prefix &prefix = prefixes[prefix_index];
+            for (Index &child : prefix.children)
+                child = split_depth_indices[prefix.thread_index][child];
+            prefix.is_done = true;
+        }
+        merge_chrono.pause();
+
+        bool const is_last_batch = (batch_begin + n_prefixes_per_batch >= remaining_prefixes.size());
+        if (with_checkpoints and (is_last_batch or since_checkpoint_chrono.get_seconds() >= m_checkpoint_period)) {
+            checkpoint_chrono.start();
+            write_checkpoint(split_depth, prefixes);
+            checkpoint_chrono.pause();
+
+            // util::Chrono::reset() requires the stopwatch to be paused
+            since_checkpoint_chrono.pause();
+            since_checkpoint_chrono.reset();
+            since_checkpoint_chrono.start();
+        }
+    }
+
+    // Insert the nodes above the split depth, in the same order as the sequential algorithm
+    merge_chrono.start();
+    main_worker.set_prefixes(prefixes, split_depth);
+    std::vector<Index> root_children = main_worker.find_children(0);
+    (void)root_children;
+    merge_chrono.pause();
+
+    total_symtree_chrono.pause();
+
+    m_tree.finish_initialization();
+
+    // LOGGING
+    {
+        LOG_BEGIN_SECTION("inf::TreeFiller timing")
+        util::logger << "Split at depth " << split_depth << " into "
+                     << prefixes.size() << " prefixes for " << n_threads << " threads" << util::cr;
+        if (n_resumed_prefixes > 0)
+            util::logger << n_resumed_prefixes << " prefixes were resumed from the checkpoint" << util::cr;
+        for (Index thread_index : util::Range(n_threads)) {
+            util::logger
+                << util::begin_comment << "Thread " << thread_index + 1 << " event symmetrization: " << util::end_comment
+                << thread_workers[thread_index]->sym_chrono << util::cr
+                << util::begin_comment << "Thread " << thread_index + 1 << " node insertion in cache: " << util::end_comment
+                << thread_workers[thread_index]->node_chrono << util::cr;
+        }
+        util::logger
+            << util::begin_comment << "Parallel filling: " << util::end_comment
+            << parallel_chrono << util::cr
+            << util::begin_comment << "Merging: " << util::end_comment
+            << merge_chrono << util::cr;
+        if (with_checkpoints) {
+            util::logger
+                << util::begin_comment << "Checkpoints: " << util::end_comment
+                << checkpoint_chrono << util::cr;
+        }
+        util::logger
+            << util::begin_comment << "Total: " << util::end_comment
+            << total_symtree_chrono << util::cr;
+        LOG_END_SECTION
+    }
+}
+
+void inf::TreeFiller::read_checkpoint(inf::TreeFiller::Worker &main_worker,
+                                      Index &split_depth,
+                                      std::vector<inf::TreeFiller::Prefix> &prefixes) {
+    util::InputFileStream stream(m_checkpoint_filename, util::FileStream::Format::text, m_inflation.get_symtree_metadata());
+
+    stream.write_or_read_and_hard_assert("inf::TreeFiller checkpoint");
+    stream.io(split_depth);
+    HARD_ASSERT_LT(0, split_depth)
+    HARD_ASSERT_LT(split_depth, m_inflation_n_parties)
+
+    // The prefixes are not stored, since they can be recomputed quickly and deterministically
+    prefixes.clear();
+    main_worker.collect_prefixes(0, split_depth, prefixes);
+
+    io_checkpoint(stream, prefixes);
+}
+
+void inf::TreeFiller::write_checkpoint(Index split_depth, std::vector<inf::TreeFiller::Prefix> &prefixes) {
+    std::string const temporary_filename = m_checkpoint_filename + "_tmp";
+    {
+        util::OutputFileStream stream(temporary_filename, util::FileStream::Format::text, m_inflation.get_symtree_metadata());
+
+        stream.write_or_read_and_hard_assert("inf::TreeFiller checkpoint");
+        stream.io(split_depth);
+
+        io_checkpoint(stream, prefixes);
+    }
+
+    std::string const extension = util::FileStream::get_extension(util::FileStream::Format::text);
+    if (std::rename((temporary_filename + extension).c_str(), (m_checkpoint_filename + extension).c_str()) != 0)
+        THROW_ERROR("Could not move the checkpoint " + temporary_filename + extension + " to " + m_checkpoint_filename + extension)
+}
+
+void inf::TreeFiller::io_checkpoint(util::FileStream &stream, std::vector<inf::TreeFiller::Prefix> &prefixes) {
+    stream.write_or_read_and_hard_assert(prefixes.size());
+
+    for (inf::TreeFiller::Prefix &prefix : prefixes) {
+        stream.write_or_read_and_hard_assert(prefix.working_event);
+
+        uint8_t is_done = prefix.is_done ? 1 : 0;
+        stream.io(is_done);
+        prefix.is_done = (is_done == 1);
+
+        if (prefix.is_done)
+            stream.io(prefix.children);
+    }
+
+    m_tree.io_nodes(stream);
+}
+
+inf::TreeFiller::Worker::Worker(inf::TreeFiller const &tree_filler, inf::EventTree &tree)
+    : sym_chrono(util::Chrono::State::paused),
+      node_chrono(util::Chrono::State::paused),
+      m_tree_filler(tree_filler),
+      m_tree(&tree),
+      m_working_event(tree_filler.m_inflation.get_all_unknown_event()),
+      m_waiting_syms(tree_filler.m_inflation_n_parties),
+      m_pushed_parties(),
+      m_prefixes(nullptr),
+      m_next_prefix(0),
+      m_split_depth(tree_filler.m_inflation_n_parties) {
+
+    // Initially, every transformed event is unknown from the first position onwards
+    for (Index i : util::Range(m_tree_filler.m_inflation_inverse_party_symmetries.size())) {
+        m_waiting_syms[m_tree_filler.m_inflation_inverse_party_symmetries[i][0]].push_back({i, 0});
+    }
+}
+
+void inf::TreeFiller::Worker::set_tree(inf::EventTree &tree) {
+    m_tree = &tree;
+}
+
+void inf::TreeFiller::Worker::collect_prefixes(Index depth, Index split_depth,
+                                               std::vector<inf::TreeFiller::Prefix> &prefixes) {
+    ASSERT_LT(depth, split_depth)
+    ASSERT_EQUAL(m_working_event[depth], m_tree_filler.m_unknown_outcome)
+
+    inf::Outcome &outcome_to_fill = m_working_event[depth];
+    for (outcome_to_fill = 0; outcome_to_fill < m_tree_filler.m_n_outcomes; ++outcome_to_fill) {
+        Index const n_pushed = m_pushed_parties.size();
+
+        if (is_symmetrized(depth)) {
+            if (depth + 1 == split_depth)
+                prefixes.push_back({m_working_event, m_waiting_syms, 0, false, {}});
+            else
+                collect_prefixes(depth + 1, split_depth, prefixes);
+        }
+
+        pop_waiting_syms(n_pushed);
+    }
+
+    outcome_to_fill = m_tree_filler.m_unknown_outcome;
+}
+
+void inf::TreeFiller::Worker::fill_prefixes(std::vector<inf::TreeFiller::Prefix> &prefixes,
+                                            std::vector<Index> const &prefix_indices,
+                                            Index split_depth,
+                                            std::atomic<Index> &next_prefix,
+                                            Index thread_index) {
+    while (true) {
+        Index const i = next_prefix++;
+        if (i >= prefix_indices.size())
+            break;
+
+        // Each prefix is only ever accessed by the thread that took it
+        inf::TreeFiller::Prefix &prefix = prefixes[prefix_indices[i]];
+        m_working_event = prefix.working_event;
+        m_waiting_syms = prefix.waiting_syms;
+        m_pushed_parties.clear();
+
+        prefix.children = find_children(split_depth);
+        prefix.thread_index = thread_index;
+    }
+}
+
+void inf::TreeFiller::Worker::set_prefixes(std::vector<inf::TreeFiller::Prefix> const &prefixes, Index split_depth) {
+    ASSERT_LT(split_depth, m_tree_filler.m_inflation_n_parties)
+    m_prefixes = &prefixes;
+    m_next_prefix = 0;
+    m_split_depth = split_depth;
+}
+
+std::vector<Index> inf::TreeFiller::Worker::find_children(Index depth) {
+    ASSERT_LT(depth, m_tree_filler.m_inflation_n_parties)
+    ASSERT_EQUAL(m_working_event[depth], m_tree_filler.m_unknown_outcome)
+
+    // The subtrees below the split depth were already filled by the threads
+    if (depth == m_split_depth) {
+        ASSERT_LT(m_next_prefix, m_prefixes->size())
+        inf::TreeFiller::Prefix const &prefix = (*m_prefixes)[m_next_prefix++];
+        ASSERT_EQUAL(prefix.working_event, m_working_event)
+        return prefix.children;
+    }
 
     // Will be returned
     std::vector<Index> child_nodes;
 
-    std::vector<Index> const &current_syms = m_current_syms[depth];
-    bool const not_at_last_depth = (depth < m_inflation_n_parties - 1);
-    // We use forward declarations, this is maybe a bit faster
-    Index depth_bis;
-    // This will only be relevant if we're not at last depth
-    std::vector<Index> *next_syms = nullptr;
-    if (not_at_last_depth)
-        next_syms = &m_current_syms[depth + 1];
-    inf::OutcomeSym::Bare const *outcome_sym;
-    inf::PartySym::Bare const *inverse_party_sym;
-    inf::Outcome base_outcome, transformed_outcome;
+    bool const not_at_last_depth = (depth < m_tree_filler.m_inflation_n_parties - 1);
     inf::Outcome &outcome_to_fill = m_working_event[depth];
 
     // We fill outcome_to_fill = m_working_event[depth] with all possible values,
     // and for each value, we check whether or not m_working_event is symmetrized
-    for (outcome_to_fill = 0; outcome_to_fill < m_n_outcomes; ++outcome_to_fill) {
-        // By default, m_working_event is symmetrized, but if we find a symmetry that
-        // proves it is not symmetrized, is_symmetrized will be set to false
-        bool is_symmetrized = true;
-
-        if (not_at_last_depth)
-            next_syms->clear();
-
-        // This loop is in charge of verifying whether or not m_working_event is symmetrized,
-        // which is stored in is_symmetrized, and it furthermore adequately initializes the
-        // next_syms for the next recursive call
-        m_sym_chrono.start();
-        for (Index const sym_index : current_syms) {
-            outcome_sym = &m_inflation_outcome_symmetries[sym_index];
-            inverse_party_sym = &m_inflation_inverse_party_symmetries[sym_index];
-
-            // We want to compare event_bis := party_sym(outcome_sym(m_working_event))
-            // with m_working_event with respect to the lexicographic ordering.
-            // If event_bis < m_working_event, then m_working_event is not symmetrized
-            // no matter how we will fill it, and we dismiss m_working_event.
-            // If event_bis > m_working_event, then it can be that the current symmetry indexed
-            // by sym_index will not help to symmetrize the event no matter how we fill it
-            // and we can hence dismiss sym_index from the next_syms.
-            for (depth_bis = 0; depth_bis < m_inflation_n_parties; ++depth_bis) {
-                // This is (party_sym(m_working_event))[depth_bis] = m_working_event[inverse_party_sym[depth_bis]]
-                transformed_outcome = m_working_event[(*inverse_party_sym)[depth_bis]];
-
-                // This happens when e.g. m_working_event = (2,?,?,...) and party_sym(m_working_event) = (?,2,?,...)
-                // In this case, event_bis > m_working_event, but we cannot say whether
-                // or not the sym_index will help to symmetrize m_working_event when it
-                // will be filled more, so we add sym_index to the next_syms.
-                // Furthermore, we do not know whether or not m_working_event is symmetrized
-                // (if all outcome symmetries are there, (0,?,?,...) will be the symmetrized one),
-                // so we do not touch is_symmetrized before breaking
-                //
-                // The other case where this can happen is if e.g., m_working_event = (0,0,?)
-                // and the symmetry index by sym_index is just the outcome swap of 2 and 3.
-                // The above reasoning applies equally well in that case.
-                if (transformed_outcome == m_unknown_outcome) {
-                    if (not_at_last_depth)
-                        next_syms->push_back(sym_index);
-
-                    break;
-                }
-
-                base_outcome = m_working_event[depth_bis];
-                ASSERT_LT(base_outcome, m_unknown_outcome)
-
-                // We now have transformed_outcome = party_sym(outcome_sym(m_working_event))[depth_bis]
-                transformed_outcome = (*outcome_sym)[transformed_outcome];
-
-                // If the transformed event is "lower" than the working event, exit the loop concluding
-                // that m_working_event is not symmetrized. In this case, no need to update the next_syms,
-                // because there is anyway no child of this outcome (it is dismissed because not symmetrized)
-                if (transformed_outcome < base_outcome) {
-                    is_symmetrized = false;
-                    break;
-                }
-
-                // In this case, the symmetry transformation takes the event up in its orbit
-                // This will remain true when filling it further.
-                // This symmetry is thus "irrelevant" for future depths: it has no chance
-                // of symmetrizing the event. We don't add it to next_syms.
-                if (transformed_outcome > base_outcome)
-                    break;
-            }
+    for (outcome_to_fill = 0; outcome_to_fill < m_tree_filler.m_n_outcomes; ++outcome_to_fill) {
+        Index const n_pushed = m_pushed_parties.size();
 
-            // If this event is not symmetrized, we can stop. Note that in this case, the value of next_syms
-            // is irrelevant because this node will have no children.
-            if (not is_symmetrized)
-                break;
-        }
-        m_sym_chrono.pause();
+        bool const symmetrized = is_symmetrized(depth);
+        std::vector<Index> children{};
+        if (symmetrized and not_at_last_depth)
+            children = this->find_children(depth + 1);
+
+        // The next outcome starts again from the symmetries waiting for this depth
+        pop_waiting_syms(n_pushed);
 
         // We dismiss m_working_event with the current outcome_to_fill based on symmetry
-        if (not is_symmetrized)
+        if (not symmetrized)
             continue;
 
-        std::vector<Index> children{};
-        if (not_at_last_depth) {
-            children = this->find_children(depth + 1);
-
-            // Dismiss empty childset, unless we're at last depth
-            // This can happen if e.g. (0,1,?) looks symmetrized,
-            // but somehow all the filling (0,1,x) are not symmetrized.
-            if (children.size() == 0)
-                continue;
-        }
+        // Dismiss empty childset, unless we're at last depth
+        // This can happen if e.g. (0,1,?) looks symmetrized,
+        // but somehow all the filling (0,1,x) are not symmetrized.
+        if (not_at_last_depth and children.size() == 0)
+            continue;
 
         // We can now construct the node!
-        m_node_chrono.start();
-        child_nodes.push_back(m_tree.insert_node(depth, outcome_to_fill, children));
-        m_node_chrono.pause();
+        node_chrono.start();
+        child_nodes.push_back(m_tree->insert_node(depth, outcome_to_fill, children));
+        node_chrono.pause();
     }
 
     // We need to reset m_working_event[depth] to "?" so that the outer level
     // of the recursion still has an event where depth+1,depth+2 etc have all "?" outcomes
-    outcome_to_fill = m_unknown_outcome;
+    outcome_to_fill = m_tree_filler.m_unknown_outcome;
 
     return child_nodes;
 }
+
+bool inf::TreeFiller::Worker::is_symmetrized(Index depth) {
+    Index const n_parties = m_tree_filler.m_inflation_n_parties;
+    inf::Outcome const unknown_outcome = m_tree_filler.m_unknown_outcome;
+
+    // Only these symmetries can be affected by the outcome at position depth.
+    // The symmetries moved below are appended to the lists of later depths, so this reference remains valid.
+    std::vector<inf::TreeFiller::WaitingSym> const &waiting_syms = m_waiting_syms[depth];
+    // We use forward declarations, this is maybe a bit faster
+    Index depth_bis, waiting_party;
+    inf::OutcomeSym::Bare const *outcome_sym;
+    inf::PartySym::Bare const *inverse_party_sym;
+    inf::Outcome base_outcome, transformed_outcome;
+
+    // By default, m_working_event is symmetrized, but if we find a symmetry that
+    // proves it is not symmetrized, is_symmetrized will be set to false
+    bool is_symmetrized = true;
+
+    // This loop is in charge of verifying whether or not m_working_event is symmetrized,
+    // which is stored in is_symmetrized, and it furthermore adequately moves the
+    // waiting symmetries for the next recursive calls
+    sym_chrono.start();
+    for (inf::TreeFiller::WaitingSym const &waiting_sym : waiting_syms) {
+        outcome_sym = &m_tree_filler.m_inflation_outcome_symmetries[waiting_sym.sym_index];
+        inverse_party_sym = &m_tree_filler.m_inflation_inverse_party_symmetries[waiting_sym.sym_index];
+        ASSERT_EQUAL((*inverse_party_sym)[waiting_sym.position], depth)
+
+        // We want to compare event_bis := party_sym(outcome_sym(m_working_event))
+        // with m_working_event with respect to the lexicographic ordering.
+        // The two events agree before waiting_sym.position, so we resume the comparison from there.
+        // If event_bis < m_working_event, then m_working_event is not symmetrized
+        // no matter how we will fill it, and we dismiss m_working_event.
+        // If event_bis > m_working_event, then the current symmetry
+        // will not help to symmetrize the event no matter how we fill it
+        // and we can hence forget about it for the next depths.
+        for (depth_bis = waiting_sym.position; depth_bis < n_parties; ++depth_bis) {
+            // This is (party_sym(m_working_event))[depth_bis] = m_working_event[inverse_party_sym[depth_bis]]
+            waiting_party = (*inverse_party_sym)[depth_bis];
+            transformed_outcome = m_working_event[waiting_party];
+
+            // This happens when e.g. m_working_event = (2,?,?,...) and party_sym(m_working_event) = (?,2,?,...)
+            // In this case, event_bis > m_working_event, but we cannot say whether
+            // or not the symmetry will help to symmetrize m_working_event when it
+            // will be filled more, so it now waits for the outcome of waiting_party.
+            // Furthermore, we do not know whether or not m_working_event is symmetrized
+            // (if all outcome symmetries are there, (0,?,?,...) will be the symmetrized one),
+            // so we do not touch is_symmetrized before breaking
+            //
+            // The other case where this can happen is if e.g., m_working_event = (0,0,?)
+            // and the symmetry is just the outcome swap of 2 and 3.
+            // The above reasoning applies equally well in that case.
+            if (transformed_outcome == unknown_outcome) {
+                ASSERT_LT(depth, waiting_party)
+                m_waiting_syms[waiting_party].push_back({waiting_sym.sym_index, depth_bis});
+                m_pushed_parties.push_back(waiting_party);
+
+                break;
+            }
+
+            base_outcome = m_working_event[depth_bis];
+            ASSERT_LT(base_outcome, unknown_outcome)
+
+            // We now have transformed_outcome = party_sym(outcome_sym(m_working_event))[depth_bis]
+            transformed_outcome = (*outcome_sym)[transformed_outcome];
+
+            // If the transformed event is "lower" than the working event, exit the loop concluding
+            // that m_working_event is not symmetrized. The symmetries moved so far are
+            // irrelevant because there is anyway no child of this outcome (it is dismissed because not symmetrized)
+            if (transformed_outcome < base_outcome) {
+                is_symmetrized = false;
+                break;
+            }
+
+            // In this case, the symmetry transformation takes the event up in its orbit
+            // This will remain true when filling it further.
+            // This symmetry is thus "irrelevant" for future depths: it has no chance
+            // of symmetrizing the event. We don't make it wait for anything.
+            if (transformed_outcome > base_outcome)
+                break;
+        }
+
+        // If this event is not symmetrized, we can stop.
+        if (not is_symmetrized)
+            break;
+    }
+    sym_chrono.pause();
+
+    return is_symmetrized;
+}
+
+void inf::TreeFiller::Worker::pop_waiting_syms(Index n_pushed) {
+    ASSERT_LTE(n_pushed, m_pushed_parties.size())
+
+    while (m_pushed_parties.size() > n_pushed) {
+        m_waiting_syms[m_pushed_parties.back()].pop_back();
+        m_pushed_parties.pop_back();
+    }
+}
@@ -4,6 +4,9 @@
 #include "../events/event_tree.h"
 #include "../inf_problem/inflation.h"
 
+// For std::atomic
+#include <atomic>
+
 namespace inf {
 
 /*! \ingroup infback
@@ -114,28 +117,205 @@ namespace inf {
  * This example describes how this algorithm would be used to obtain a list representation of \f$\redinfevents\f$,
  * but it is easy to adapt it to obtain a tree representation instead, which is what the class inf::TreeFiller does.
  *
+ * ### Waiting symmetries
+ *
+ * Comparing the transformed event `g(working_event)` with `working_event` for some symmetry `g` amounts to scanning the positions
+ * from left to right until the two events differ, or until `g(working_event)` has an unknown outcome.
+ * In the latter case, say at position `k`, the comparison can only progress once the outcome at position `g^{-1}(k)` is filled,
+ * and the first `k` positions do not need to be compared again.
+ * We thus say that `g` waits for the party `g^{-1}(k)`, and we store `g` with `k` in a list attached to that party
+ * (see inf::TreeFiller::Worker::m_waiting_syms).
+ * When filling the outcome at some depth, only the symmetries waiting for the party at this depth have to be examined:
+ * the comparison of the other symmetries is unaffected by the new outcome.
+ * This way, the work per node scales with the number of symmetries whose comparison actually depends on that node,
+ * rather than with the size of the symmetry group.
+ *
+ * ### Multithreading
+ *
+ * With more than one thread, the recursion above is first run sequentially down to some split depth, recording every prefix
+ * (e.g., `(0,1,?,?,?)`) that looks symmetrized, together with the symmetries that remain relevant for it.
+ * Each thread then repeatedly takes the next unprocessed prefix and fills the corresponding subtree in its own inf::EventTree,
+ * using its own working event and list of relevant symmetries (see inf::TreeFiller::Worker).
+ * The nodes of the per-thread inf::EventTree are then merged into the shared inf::EventTree with inf::EventTree::merge_nodes(),
+ * and the sequential recursion is run once more down to the split depth, plugging in the merged children of each prefix.
+ * Since inf::EventTree::finish_initialization() renumbers the nodes canonically, the resulting inf::EventTree does not depend
+ * on the number of threads.
+ *
+ * ### Checkpoints
+ *
+ * Filling a large inf::EventTree can take hours. If a checkpoint filename is given, the prefixes are processed in batches,
+ * and after a batch, if more than the checkpoint period has elapsed since the last checkpoint, the nodes inserted so far
+ * together with the children of the completed prefixes are written to the checkpoint file (see inf::EventTree::io_nodes()).
+ * A final checkpoint is written once all prefixes are completed.
+ * If the checkpoint file exists when the inf::TreeFiller is constructed, the filling resumes from it, skipping the completed prefixes.
+ * It is up to the caller to delete the checkpoint with inf::TreeFiller::remove_checkpoint() once the inf::EventTree is safely stored.
+ *
  * This class is tested in the application user::inf_tree_filler.
  * */
 class TreeFiller {
   public:
-    /*! \brief To store the symmetrized events \f$\redinfevents\f$ of the \p inflation in the \p tree
+    /*! \brief To store the symmetrized events \f$\redinfevents\f$ of the \p inflation in the \p tree, using \p n_threads threads
      * \details This convenience static method avoids the use of declaring an otherwise-unused instance of inf::InfTreeSplitter. */
-    static void fill_tree(inf::EventTree &tree, inf::Inflation const &inflation);
+    static void fill_tree(inf::EventTree &tree,
+                          inf::Inflation const &inflation,
+                          Index n_threads = 1,
+                          std::string const &checkpoint_filename = "",
+                          double checkpoint_period = default_checkpoint_period);
 
-    /*! \brief To store the symmetrized events \f$\redinfevents\f$ of the \p inflation in the \p tree */
+    /*! \brief To store the symmetrized events \f$\redinfevents\f$ of the \p inflation in the \p tree, using \p n_threads threads
+     * \param tree The inf::EventTree to fill, which should be empty
+     * \param inflation The inf::Inflation whose symmetrized events should be stored
+     * \param n_threads The number of threads
+     * \param checkpoint_filename The file (without extension) used to checkpoint the progress as explained above, or the empty string
+     * to disable checkpoints
+     * \param checkpoint_period The minimal number of seconds between two checkpoints */
     TreeFiller(inf::EventTree &tree,
-               inf::Inflation const &inflation);
+               inf::Inflation const &inflation,
+               Index n_threads = 1,
+               std::string const &checkpoint_filename = "",
+               double checkpoint_period = default_checkpoint_period);
+
+    /*! \brief The default number of seconds between two checkpoints */
+    static double const default_checkpoint_period;
+
+    /*! \brief Deletes the checkpoint file \p checkpoint_filename (without extension), if it exists */
+    static void remove_checkpoint(std::string const &checkpoint_filename);
 
   private:
-    /*! \brief This util::Chrono tracks the time spent checking whether or not events are symmetrized */
-    util::Chrono m_sym_chrono;
-    /*! \brief This util::Chrono tracks the time spent inserting nodes in the underlying inf::EventTree */
-    util::Chrono m_node_chrono;
+    /*! \brief When multithreading, the split depth is chosen such that there are at least this many prefixes per thread
+     * \details Having many more prefixes than threads allows the threads to balance the work dynamically.
+     * This is also the number of prefixes per thread in each batch. */
+    static Index const target_prefixes_per_thread;
+    /*! \brief When checkpointing, the split depth is chosen such that there are at least this many batches of prefixes */
+    static Index const target_batches_with_checkpoints;
+
+    /*! \brief A symmetry that waits for the outcome of some party, as explained above */
+    struct WaitingSym {
+        /*! \brief The index of the symmetry, relative to both `m_inflation_inverse_party_symmetries` and `m_inflation_outcome_symmetries` */
+        Index sym_index;
+        /*! \brief The first position at which the transformed event has an unknown outcome: the previous positions agree with the working event */
+        Index position;
+    };
+
+    /*! \brief A symmetrized-looking prefix of an event, at which the multithreaded tree filling splits the work */
+    struct Prefix {
+        /*! \brief The working event, whose outcomes are unknown from the split depth onwards */
+        inf::Event working_event;
+        /*! \brief The waiting symmetries at the split depth, see inf::TreeFiller::Worker::m_waiting_syms */
+        std::vector<std::vector<WaitingSym>> waiting_syms;
+        /*! \brief The index of the thread that filled the subtree of this prefix */
+        Index thread_index;
+        /*! \brief Whether the subtree of this prefix has been filled and merged in the shared inf::EventTree */
+        bool is_done;
+        /*! \brief The nodes at the split depth that complete this prefix, relative to the inf::EventTree of the thread
+         * that filled them, and then relative to the shared inf::EventTree once merged */
+        std::vector<Index> children;
+    };
+
+    /*! \brief This class holds the state of the recursive tree-filling algorithm presented above, so that each thread can have its own */
+    class Worker {
+      public:
+        /*! \brief The \p tree_filler holds the inflation symmetries, while \p tree is the inf::EventTree in which the nodes are inserted */
+        Worker(inf::TreeFiller const &tree_filler, inf::EventTree &tree);
+        /*! \brief To insert the nodes in another inf::EventTree */
+        void set_tree(inf::EventTree &tree);
+        //! \cond
+        Worker(Worker const &other) = delete;
+        Worker(Worker &&other) = delete;
+        Worker &operator=(Worker const &other) = delete;
+        Worker &operator=(Worker &&other) = delete;
+        //! \endcond
+
+        /*! \brief This recursive function implements the tree-filling algorithm presented above
+         * \details A call to `find_children(depth)` assumes that `m_working_event` is set to something like
+         * `(0,1,0,2,?,?,?)`, where the first "?" is at position `depth`.
+         * Then, `find_children(depth)` fills the outcome at position `depth` with the different possible outcomes,
+         * checks whether the event is clearly non-symmetrized (in which case the attempted outcome at position `depth` is dismissed),
+         * but if not, goes on to call `find_children(depth+1)`.
+         * If the call to `find_children(depth+1)` returns a non-empty set of children, a new node is inserted in `m_tree` at position `depth`
+         * with the outcome tried at position `depth`.
+         * Eventually, when all outcomes at position `depth` have been tried, the resulting indices of the nodes inserted in `m_tree`
+         * (obtained with inf::EventTree::insert_node()) are returned.
+         *
+         * If inf::TreeFiller::Worker::set_prefixes() was called, the recursion stops at the split depth and returns the children
+         * of the next prefix instead. */
+        std::vector<Index> find_children(Index depth);
+
+        /*! \brief This follows the same recursion as inf::TreeFiller::Worker::find_children(), but stops at \p split_depth
+         * to append the symmetrized-looking prefixes to \p prefixes, in the order in which inf::TreeFiller::Worker::find_children() visits them */
+        void collect_prefixes(Index depth, Index split_depth, std::vector<Prefix> &prefixes);
+
+        /*! \brief Repeatedly takes the prefix `prefixes[prefix_indices[next_prefix++]]` and fills its subtree, until there are no prefixes left
+         * \details This is the task of each thread, which is identified by \p thread_index. */
+        void fill_prefixes(std::vector<Prefix> &prefixes,
+                           std::vector<Index> const &prefix_indices,
+                           Index split_depth,
+                           std::atomic<Index> &next_prefix,
+                           Index thread_index);
+
+        /*! \brief Makes inf::TreeFiller::Worker::find_children() return the children of the \p prefixes (in order) upon reaching \p split_depth */
+        void set_prefixes(std::vector<Prefix> const &prefixes, Index split_depth);
+
+        /*! \brief This util::Chrono tracks the time spent checking whether or not events are symmetrized */
+        util::Chrono sym_chrono;
+        /*! \brief This util::Chrono tracks the time spent inserting nodes in the underlying inf::EventTree */
+        util::Chrono node_chrono;
+
+      private:
+        /*! \brief Checks whether `m_working_event`, filled up to and including \p depth, looks symmetrized
+         * \details This examines the symmetries waiting for the party at \p depth, and moves those that remain relevant
+         * to the list of the party they now wait for. These moves must be undone with inf::TreeFiller::Worker::pop_waiting_syms()
+         * before trying another outcome at \p depth. */
+        bool is_symmetrized(Index depth);
+        /*! \brief Undoes the moves of waiting symmetries, until only \p n_pushed of them remain in `m_pushed_parties` */
+        void pop_waiting_syms(Index n_pushed);
+
+        /*! \brief The inf::TreeFiller holding the inflation symmetries */
+        inf::TreeFiller const &m_tree_filler;
+        /*! \brief The inf::EventTree to fill */
+        inf::EventTree *m_tree;
+
+        /*! \brief The event that is used (modified and read) by the recursive function inf::TreeFiller::Worker::find_children() */
+        inf::Event m_working_event;
+
+        /*! \brief The list (for each party, i.e., depth) of the symmetries that wait for the outcome of that party, as explained above
+         * \details A call of `find_children(depth)` only examines `m_waiting_syms[depth]`, which it does not modify.
+         * The symmetries that remain relevant are appended to `m_waiting_syms[later_depth]`, and are removed again
+         * (see inf::TreeFiller::Worker::pop_waiting_syms()) before the next outcome is tried.
+         * The symmetries that are found to be irrelevant for all further fillings, because they take the working event up in its orbit,
+         * are simply not appended anywhere. */
+        std::vector<std::vector<WaitingSym>> m_waiting_syms;
+        /*! \brief The stack of parties to whose list in `m_waiting_syms` a symmetry was appended, used to undo these appends */
+        std::vector<Index> m_pushed_parties;
+
+        /*! \brief The prefixes whose children are returned at `m_split_depth`, see inf::TreeFiller::Worker::set_prefixes() */
+        std::vector<Prefix> const *m_prefixes;
+        /*! \brief The next prefix of `m_prefixes` to return */
+        Index m_next_prefix;
+        /*! \brief The depth at which the children of `m_prefixes` are returned, which is the number of parties if there are no prefixes */
+        Index m_split_depth;
+    };
+
+    /*! \brief Fills `m_tree` with a single inf::TreeFiller::Worker */
+    void fill_sequentially();
+    /*! \brief Fills `m_tree` with \p n_threads inf::TreeFiller::Worker as explained above, writing checkpoints if required */
+    void fill_by_prefixes(Index n_threads);
+
+    /*! \brief Reads the checkpoint file, setting \p split_depth, \p prefixes (computed with \p main_worker) and the nodes of `m_tree` */
+    void read_checkpoint(inf::TreeFiller::Worker &main_worker, Index &split_depth, std::vector<Prefix> &prefixes);
+    /*! \brief Writes the checkpoint file, going through a temporary file so that an interruption cannot corrupt the previous checkpoint */
+    void write_checkpoint(Index split_depth, std::vector<Prefix> &prefixes);
+    /*! \brief Reads or writes the part of the checkpoint that follows the split depth */
+    void io_checkpoint(util::FileStream &stream, std::vector<Prefix> &prefixes);
 
     /*! \brief The inf::EventTree to fill */
     inf::EventTree &m_tree;
     /*! \brief The inf::Inflation whose symmetrized event set \f$\redinfevents\f$ will be stored in the inf::EventTree */
     inf::Inflation const &m_inflation;
+    /*! \brief The checkpoint file (without extension), or the empty string if there are no checkpoints */
+    std::string const m_checkpoint_filename;
+    /*! \brief The minimal number of seconds between two checkpoints */
+    double const m_checkpoint_period;
 
     /*! \brief We store the image of the inflation inverse party symmetries for faster execution */
     std::vector<inf::PartySym::Bare> m_inflation_inverse_party_symmetries;
@@ -147,31 +327,5 @@ class TreeFiller {
     inf::Outcome const m_unknown_outcome;
     /*! \brief The number of outcomes, which is equal to `m_unknown_outcome` */
     inf::Outcome const m_n_outcomes;
-
-    /*! \brief This recursive function implements the tree-filling algorithm presented above
-     * \details A call to `find_children(depth)` assumes that `m_working_event` is set to something like
-     * `(0,1,0,2,?,?,?)`, where the first "?" is at position `depth`.
-     * Then, `find_children(depth)` fills the outcome at position `depth` with the different possible outcomes,
-     * checks whether the event is clearly non-symmetrized (in which case the attempted outcome at position `depth` is dismissed),
-     * but if not, goes on to call `find_children(depth+1)`.
-     * If the call to `find_children(depth+1)` returns a non-empty set of children, a new node is inserted in `m_tree` at position `depth`
-     * with the outcome tried at position `depth`.
-     * Eventually, when all outcomes at position `depth` have been tried, the resulting indices of the nodes inserted in `m_tree`
-     * (obtained with inf::EventTree::insert_node()) are returned. */
-    std::vector<Index> find_children(Index depth);
-
-    /*! \brief The event that is used (modified and read) by the recursive function inf::TreeFiller::find_children() */
-    inf::Event m_working_event;
-
-    /*! \brief The list (for each depth) of lists of relevant symmetries that is used (modified and read) by the recursive function inf::TreeFiller::find_children()
-     * \details The outer list corresponds to depth in the tree, the inner list consists of the indices of symmetries
-     * (relative to both `m_inflation_inverse_party_symmetries` and `m_inflation_outcome_symmetries`)
-     * that are relevant at the specified depth.
-     * The idea is that a call of `find_children[depth]` will use only the symmetries specified in `m_current_syms[depth]`, because
-     * the symmetries not specified in `m_current_syms[depth]` had a reason to be discarded.
-     * Then, in `find_children[depth]`, it may be that upon setting `m_working_event[depth]` to a specific outcome, it is clear
-     * that a symmetry will be irrelevant when trying to symmetrize `m_working_event` for all further fillings.
-     * In this case, and only in this case, this symmetry is ommitted from `m_current_syms[depth+1]`. */
-    std::vector<std::vector<Index>> m_current_syms;
 };
 } // namespace inf
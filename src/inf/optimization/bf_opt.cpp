@@ -1,8 +1,9 @@
 #include "bf_opt.h"
 #include "../../util/logger.h"
 
-inf::BruteForceOpt::BruteForceOpt(inf::ConstraintSet::Ptr const &constraints)
-    : inf::Optimizer(constraints),
+inf::BruteForceOpt::BruteForceOpt(inf::ConstraintSet::Ptr const &constraints,
+                                  inf::Optimizer::PreOracle pre_oracle)
+    : inf::Optimizer(constraints, pre_oracle),
       m_evaluators(m_constraints->get_marg_evaluators()) {}
 
 inf::Optimizer::PreSolution inf::BruteForceOpt::get_pre_solution() {
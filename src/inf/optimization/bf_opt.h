@@ -21,8 +21,10 @@ class BruteForceOpt : public inf::Optimizer {
     /*! \brief Initializes an inf::BruteForceOpt with the relevant \p constraints
         \param constraints An optimizer gets access to an inf::ConstraintSet, which is typically used outside of the optimizer.
         This parameter allows to forward the inf::Inflation at hand, but also the current value of the inf::DualVector to optimize
-        through inf::ConstraintSet::get_marg_evaluators(). */
-    BruteForceOpt(inf::ConstraintSet::Ptr const &constraints);
+        through inf::ConstraintSet::get_marg_evaluators().
+        \param pre_oracle See inf::Optimizer::PreOracle. */
+    BruteForceOpt(inf::ConstraintSet::Ptr const &constraints,
+                  inf::Optimizer::PreOracle pre_oracle = inf::Optimizer::PreOracle::none);
 
     inf::Optimizer::PreSolution get_pre_solution() override;
 
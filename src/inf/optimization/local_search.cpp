@@ -0,0 +1,98 @@
+#include "local_search.h"
+#include "../../util/logger.h"
+
+// For std::shuffle
+#include <algorithm>
+// For std::chrono::system_clock
+#include <chrono>
+// For std::iota
+#include <numeric>
+
+Index const inf::LocalSearch::max_n_descents = 16;
+
+inf::LocalSearch::LocalSearch(inf::ConstraintSet::Ptr const &constraints)
+    : m_constraints(constraints),
+      m_evaluators(m_constraints->get_marg_evaluators()),
+      m_n_outcomes(m_constraints->get_inflation()->get_network()->get_n_outcomes()),
+      m_parties(m_constraints->get_inflation()->get_n_parties()),
+      m_generator(static_cast<std::default_random_engine::result_type>(std::chrono::system_clock::now().time_since_epoch().count())),
+      m_n_calls(0),
+      m_n_successes(0) {
+    std::iota(m_parties.begin(), m_parties.end(), 0);
+}
+
+inf::LocalSearch::ScoredEvents inf::LocalSearch::get_nonpositive_events(std::set<inf::Event> const &seed_events, Index n_events) {
+    HARD_ASSERT_LT(Index(0), n_events)
+
+    ++m_n_calls;
+
+    // Pick at most max_n_descents seeds at random
+    std::vector<inf::Event const *> seeds;
+    seeds.reserve(seed_events.size());
+    for (inf::Event const &seed_event : seed_events)
+        seeds.push_back(&seed_event);
+    std::shuffle(seeds.begin(), seeds.end(), m_generator);
+    if (seeds.size() > inf::LocalSearch::max_n_descents)
+        seeds.resize(inf::LocalSearch::max_n_descents);
+
+    inf::LocalSearch::ScoredEvents scored_events;
+    std::set<inf::Event> found_events;
+
+    for (Index const i : util::Range(inf::LocalSearch::max_n_descents)) {
+        Num const score = i < seeds.size()
+                              ? descend_from(*seeds[i])
+                              : descend_from(m_constraints->get_inflation()->get_random_event());
+
+        if (score <= 0 and found_events.insert(m_evaluators.get_inflation_event()).second) {
+            scored_events.emplace_back(score, m_evaluators.get_inflation_event());
+            if (scored_events.size() >= n_events)
+                break;
+        }
+    }
+
+    if (not scored_events.empty())
+        ++m_n_successes;
+
+    std::sort(scored_events.begin(), scored_events.end());
+    return scored_events;
+}
+
+void inf::LocalSearch::log_status() const {
+    util::logger << "local search = " << m_n_successes << "/" << m_n_calls << ", ";
+}
+
+Num inf::LocalSearch::descend_from(inf::Event const &seed_event) {
+    ASSERT_EQUAL(seed_event.size(), m_parties.size())
+
+    for (Index const party : m_parties)
+        m_evaluators.set_outcome(party, seed_event[party]);
+
+    Num score = m_evaluators.evaluate_dual_vector();
+
+    for (bool improved = true; improved;) {
+        improved = false;
+        std::shuffle(m_parties.begin(), m_parties.end(), m_generator);
+
+        for (Index const party : m_parties) {
+            inf::Outcome const current_outcome = m_evaluators.get_inflation_event()[party];
+            inf::Outcome best_outcome = current_outcome;
+
+            for (inf::Outcome outcome = 0; outcome < m_n_outcomes; ++outcome) {
+                if (outcome == current_outcome)
+                    continue;
+
+                m_evaluators.set_outcome(party, outcome);
+                Num const outcome_score = m_evaluators.evaluate_dual_vector();
+                if (outcome_score < score) {
+                    score = outcome_score;
+                    best_outcome = outcome;
+                }
+            }
+
+            m_evaluators.set_outcome(party, best_outcome);
+            improved = improved or best_outcome != current_outcome;
+        }
+    }
+
+    return score;
+}
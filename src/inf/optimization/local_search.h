@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../constraints/constraint_set.h"
+
+// For std::default_random_engine
+#include <random>
+// For std::set
+#include <set>
+
+/*! \file */
+
+namespace inf {
+
+/*! \ingroup opt
+ * \brief A cheap heuristic looking for inflation events with a score smaller or equal to zero, meant to run before an exact inf::Optimizer
+ * \details This class looks for events \f$\infevent\in\infevents\f$ such that \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist} \leq 0\f$
+ * with a randomized greedy coordinate descent: starting from a seed event, it visits the inflation parties in a random order, and sets each
+ * of them to the outcome that minimizes the score given the outcomes of the other parties. This is repeated until no party can improve the score.
+ * The scores are obtained with inf::Marginal::EvaluatorSet::set_outcome(), so that changing the outcome of one party only updates
+ * the marginal events involving that party.
+ *
+ * Within an inf::FeasProblem, the seeds are the events stored by the inf::FrankWolfe algorithm: the dual vector changes little
+ * from one iteration to the next, such that the events that were good for the previous dual vectors are good starting points for the current one.
+ * The heuristic cannot prove that the minimum is positive, so it is only useful with inf::Optimizer::StopMode::sat, see inf::Optimizer::PreOracle.
+ *
+ * The events that are returned are not necessarily the representatives of their orbits stored in the inf::EventTree,
+ * but all the events of an orbit have the same score. */
+class LocalSearch {
+  public:
+    typedef std::unique_ptr<inf::LocalSearch> UniquePtr;
+
+    /*! \brief An inflation event (second) together with its score (first), this is the same type as inf::Optimizer::ScoredEvent */
+    typedef std::pair<Num, inf::Event> ScoredEvent;
+    /*! \brief A list of inf::LocalSearch::ScoredEvent */
+    typedef std::vector<inf::LocalSearch::ScoredEvent> ScoredEvents;
+
+    /*! \brief The maximal number of descents performed by a single call to inf::LocalSearch::get_nonpositive_events() */
+    static Index const max_n_descents;
+
+    /*! \brief Initializes the inf::Marginal::EvaluatorSet with inf::ConstraintSet::get_marg_evaluators()
+     * \param constraints The inf::ConstraintSet whose current inf::DualVector should be evaluated */
+    LocalSearch(inf::ConstraintSet::Ptr const &constraints);
+    //! \cond ignore deleted
+    LocalSearch(inf::LocalSearch const &other) = delete;
+    LocalSearch(inf::LocalSearch &&other) = delete;
+    LocalSearch &operator=(inf::LocalSearch const &other) = delete;
+    LocalSearch &operator=(inf::LocalSearch &&other) = delete;
+    //! \endcond
+
+    /*! \brief Looks for distinct inflation events with a score smaller or equal to zero
+     * \param seed_events The events from which the descents start. At most inf::LocalSearch::max_n_descents of them are picked at random,
+     * and random events are used if there are not enough of them.
+     * \param n_events The search stops once this many distinct events with a score smaller or equal to zero are found
+     * \return The events found, sorted by increasing score, which is empty if the heuristic failed */
+    inf::LocalSearch::ScoredEvents get_nonpositive_events(std::set<inf::Event> const &seed_events, Index n_events);
+
+    /*! \brief Logs how often the heuristic succeeded, this is meant to be called regularly within the inf::FeasProblem */
+    void log_status() const;
+
+  private:
+    /*! \brief Performs one greedy coordinate descent starting from \p seed_event
+     * \return The score of the local minimum, whose event is then stored in `m_evaluators` */
+    Num descend_from(inf::Event const &seed_event);
+
+    /*! \brief The inf::ConstraintSet whose current inf::DualVector should be evaluated */
+    const inf::ConstraintSet::Ptr m_constraints;
+    /*! \brief These inf::Marginal::Evaluator are obtained with inf::ConstraintSet::get_marg_evaluators() */
+    inf::Marginal::EvaluatorSet m_evaluators;
+    /*! \brief The number of outcomes of each inflation party */
+    const inf::Outcome m_n_outcomes;
+    /*! \brief The inflation parties, shuffled before each sweep of a descent */
+    std::vector<Index> m_parties;
+    /*! \brief The source of randomness for picking the seeds and the order of the parties */
+    std::default_random_engine m_generator;
+    /*! \brief The number of calls to inf::LocalSearch::get_nonpositive_events() */
+    Index m_n_calls;
+    /*! \brief The number of calls to inf::LocalSearch::get_nonpositive_events() that found at least one event */
+    Index m_n_successes;
+};
+
+} // namespace inf
@@ -2,6 +2,7 @@
 #include "../symmetry/symmetry.h"
 // Add other optimizers here
 #include "bf_opt.h"
+#include "sharded_opt.h"
 #include "tree_opt.h"
 
 #include "../../util/logger.h"
@@ -24,9 +25,11 @@ void inf::Optimizer::log(inf::Optimizer::StopMode stop_mode) {
 }
 
 inf::Optimizer::PreSolution::PreSolution(Num inflation_event_score,
-                                         inf::Event const &inflation_event)
+                                         inf::Event const &inflation_event,
+                                         inf::Optimizer::ScoredEvents const &other_scored_events)
     : inflation_event_score(inflation_event_score),
-      inflation_event(inflation_event) {}
+      inflation_event(inflation_event),
+      other_scored_events(other_scored_events) {}
 
 inf::Optimizer::Solution::Solution(inf::Optimizer::PreSolution const &pre_sol,
                                    inf::Inflation::ConstPtr const &inflation,
@@ -43,6 +46,10 @@ inf::Event const &inf::Optimizer::Solution::get_inflation_event() const {
     return m_pre_sol.inflation_event;
 }
 
+inf::Optimizer::ScoredEvents const &inf::Optimizer::Solution::get_other_scored_events() const {
+    return m_pre_sol.other_scored_events;
+}
+
 void inf::Optimizer::Solution::log() const {
     LOG_BEGIN_SECTION("inf::Optimizer::Solution")
     util::logger << "The inflation event " << util::cr;
@@ -52,6 +59,10 @@ void inf::Optimizer::Solution::log() const {
     inf::Optimizer::log(m_stop_mode);
     util::logger << util::begin_comment << ")" << util::end_comment
                  << "                         " << util::cr;
+    if (not get_other_scored_events().empty()) {
+        util::logger << "together with " << get_other_scored_events().size()
+                     << " other events scoring up to " << get_other_scored_events().back().first << util::cr;
+    }
     LOG_END_SECTION
 }
 
@@ -70,31 +81,129 @@ void inf::Optimizer::log(inf::Optimizer::SearchMode search_mode) {
     }
 }
 
+void inf::Optimizer::log(inf::Optimizer::ThreadSchedule thread_schedule) {
+    util::logger << util::begin_comment << "inf::Optimizer::ThreadSchedule::"
+                 << util::end_comment;
+    switch (thread_schedule) {
+    case inf::Optimizer::ThreadSchedule::static_split:
+        util::logger << "static_split";
+        break;
+    case inf::Optimizer::ThreadSchedule::work_stealing:
+        util::logger << "work_stealing";
+        break;
+    default:
+        THROW_ERROR("switch")
+    }
+}
+
+void inf::Optimizer::log(inf::Optimizer::NodeOrder node_order) {
+    util::logger << util::begin_comment << "inf::Optimizer::NodeOrder::"
+                 << util::end_comment;
+    switch (node_order) {
+    case inf::Optimizer::NodeOrder::tree:
+        util::logger << "tree";
+        break;
+    case inf::Optimizer::NodeOrder::lower_bound:
+        util::logger << "lower_bound";
+        break;
+    case inf::Optimizer::NodeOrder::best_first:
+        util::logger << "best_first";
+        break;
+    default:
+        THROW_ERROR("switch")
+    }
+}
+
+void inf::Optimizer::log(inf::Optimizer::LowerBound lower_bound) {
+    util::logger << util::begin_comment << "inf::Optimizer::LowerBound::"
+                 << util::end_comment;
+    switch (lower_bound) {
+    case inf::Optimizer::LowerBound::per_term:
+        util::logger << "per_term";
+        break;
+    case inf::Optimizer::LowerBound::branched:
+        util::logger << "branched";
+        break;
+    default:
+        THROW_ERROR("switch")
+    }
+}
+
+void inf::Optimizer::log(inf::Optimizer::PreOracle pre_oracle) {
+    util::logger << util::begin_comment << "inf::Optimizer::PreOracle::"
+                 << util::end_comment;
+    switch (pre_oracle) {
+    case inf::Optimizer::PreOracle::none:
+        util::logger << "none";
+        break;
+    case inf::Optimizer::PreOracle::local_search:
+        util::logger << "local_search";
+        break;
+    default:
+        THROW_ERROR("switch")
+    }
+}
+
 inf::Optimizer::Ptr inf::Optimizer::get_optimizer(inf::Optimizer::SearchMode search_mode,
                                                   inf::ConstraintSet::Ptr const &constraints,
                                                   inf::EventTree::IO symtree_io,
-                                                  Index n_threads) {
+                                                  Index n_threads,
+                                                  inf::Optimizer::ThreadSchedule thread_schedule,
+                                                  inf::Optimizer::NodeOrder node_order,
+                                                  inf::Optimizer::LowerBound lower_bound,
+                                                  inf::Optimizer::PreOracle pre_oracle,
+                                                  Index n_processes) {
     switch (search_mode) {
     case inf::Optimizer::SearchMode::brute_force:
-        return std::make_shared<inf::BruteForceOpt>(constraints);
+        return std::make_shared<inf::BruteForceOpt>(constraints, pre_oracle);
     case inf::Optimizer::SearchMode::tree_search:
-        return std::make_shared<inf::TreeOpt>(constraints, symtree_io, n_threads);
+        if (n_processes > 1) {
+            if (thread_schedule != inf::Optimizer::ThreadSchedule::work_stealing)
+                THROW_ERROR("inf::ShardedOpt requires inf::Optimizer::ThreadSchedule::work_stealing")
+            return std::make_shared<inf::ShardedOpt>(constraints, symtree_io, n_processes, n_threads, node_order, lower_bound, pre_oracle);
+        }
+        return std::make_shared<inf::TreeOpt>(constraints, symtree_io, n_threads, thread_schedule, node_order, lower_bound, pre_oracle);
     default:
         THROW_ERROR("Unsupported inf::Optimizer::SearchMode")
     }
 }
 
-inf::Optimizer::Optimizer(inf::ConstraintSet::Ptr const &constraints)
+inf::Optimizer::Optimizer(inf::ConstraintSet::Ptr const &constraints,
+                          inf::Optimizer::PreOracle pre_oracle)
     : m_constraints(constraints),
-      m_stop_mode(inf::Optimizer::StopMode::sat) // will be modified on call to optimize()
-{
+      m_stop_mode(inf::Optimizer::StopMode::sat), // will be modified on call to optimize()
+      m_n_events(1),                              // idem
+      m_local_search(pre_oracle == inf::Optimizer::PreOracle::local_search
+                         ? std::make_unique<inf::LocalSearch>(constraints)
+                         : nullptr) {
     inf::Optimizer::total_optimization_chrono.reset();
 }
 
-inf::Optimizer::Solution inf::Optimizer::optimize(inf::Optimizer::StopMode stop_mode) {
+inf::Optimizer::Solution inf::Optimizer::optimize(inf::Optimizer::StopMode stop_mode,
+                                                  Index n_events,
+                                                  std::set<inf::Event> const &seed_events) {
+    HARD_ASSERT_LT(Index(0), n_events)
+
     m_stop_mode = stop_mode;
+    m_n_events = n_events;
 
     inf::Optimizer::total_optimization_chrono.start();
+
+    // In sat mode, any event scoring at most zero will do, so the exact search is only needed if the heuristic fails
+    if (m_local_search != nullptr and m_stop_mode == inf::Optimizer::StopMode::sat) {
+        inf::LocalSearch::ScoredEvents const scored_events = m_local_search->get_nonpositive_events(seed_events, m_n_events);
+
+        if (not scored_events.empty()) {
+            inf::Optimizer::total_optimization_chrono.pause();
+
+            return inf::Optimizer::Solution(inf::Optimizer::PreSolution(scored_events.front().first,
+                                                                        scored_events.front().second,
+                                                                        inf::Optimizer::ScoredEvents(scored_events.begin() + 1, scored_events.end())),
+                                            m_constraints->get_inflation(),
+                                            m_stop_mode);
+        }
+    }
+
     inf::Optimizer::PreSolution pre_sol = this->get_pre_solution();
     inf::Optimizer::total_optimization_chrono.pause();
 
@@ -102,3 +211,8 @@ inf::Optimizer::Solution inf::Optimizer::optimize(inf::Optimizer::StopMode stop_
                                     m_constraints->get_inflation(),
                                     m_stop_mode);
 }
+
+void inf::Optimizer::log_status() const {
+    if (m_local_search != nullptr)
+        m_local_search->log_status();
+}
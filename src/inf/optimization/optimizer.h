@@ -3,6 +3,7 @@
 #include "../../util/frac.h"
 #include "../constraints/constraint_set.h"
 #include "../inf_problem/target_distr.h"
+#include "local_search.h"
 
 /*! \file */
 
@@ -18,6 +19,7 @@
  *   This is mostly used to test that other means of optimizaitons give the expected results on relatively small instances.
  * - inf::TreeOpt only looks at the symmetrized events \f$\infevent \in \redinfevents\f$, represented as a tree with inf::Inflation::get_symtree().
  *   It performs a tree search, and can be accelerated using a branch-and-bound approach, see inf::DualVector::StoreBounds.
+ * - inf::ShardedOpt shares the tree search of inf::TreeOpt between several worker processes.
  * */
 
 namespace inf {
@@ -46,21 +48,30 @@ class Optimizer {
 
     static void log(inf::Optimizer::StopMode stop_mode);
 
+    /*! \brief An inflation event \f$\infevent\in\infevents\f$ (second) together with its score (first), i.e., \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist}\f$ */
+    typedef std::pair<Num, inf::Event> ScoredEvent;
+    /*! \brief A list of inf::Optimizer::ScoredEvent */
+    typedef std::vector<inf::Optimizer::ScoredEvent> ScoredEvents;
+
     /*! \brief This is the base of the inf::Solution returned by an inf::Optimizer, containing the optimizer (an inflation event) and its score */
     class PreSolution {
       public:
         /*! \brief Initialize this with the score of the optimizer and the optimizer
             \param inflation_event_score the score of \p inflation_event, i.e., \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist}\f$
             for the relevant quovec \f$\quovec \in \totquovecspace\f$.
-            \param inflation_event The event \f$\infevent\in\infevents\f$ that scores \p inflation_event_score */
+            \param inflation_event The event \f$\infevent\in\infevents\f$ that scores \p inflation_event_score
+            \param other_scored_events The other lowest-scoring events, see inf::Optimizer::optimize() */
         PreSolution(Num inflation_event_score,
-                    inf::Event const &inflation_event);
+                    inf::Event const &inflation_event,
+                    inf::Optimizer::ScoredEvents const &other_scored_events = {});
 
         /*! \brief The score of \p inflation_event, i.e., \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist}\f$
             for the relevant quovec \f$\quovec \in \totquovecspace\f$. */
         const Num inflation_event_score;
         /*! \brief The event \f$\infevent\in\infevents\f$ that scores \p inflation_event_score */
         const inf::Event inflation_event;
+        /*! \brief When asking inf::Optimizer::optimize() for more than one event, the next lowest-scoring events by increasing score */
+        const inf::Optimizer::ScoredEvents other_scored_events;
     };
 
     /*! \brief To store an inf::Optimizer::PreSolution along with additional context */
@@ -80,6 +91,8 @@ class Optimizer {
         Num get_inflation_event_score() const;
         /*! \brief Get the optimizer inflation event */
         inf::Event const &get_inflation_event() const;
+        /*! \brief Get the next lowest-scoring inflation events, see inf::Optimizer::PreSolution::other_scored_events */
+        inf::Optimizer::ScoredEvents const &get_other_scored_events() const;
 
       private:
         /*! \brief The optimizer and its score */
@@ -100,6 +113,47 @@ class Optimizer {
 
     static void log(inf::Optimizer::SearchMode search_mode);
 
+    /*! \brief Describes how the threads of an inf::TreeOpt share the inf::EventTree between themselves
+     * \details This is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search`. */
+    enum class ThreadSchedule {
+        static_split,  ///< The tree is split once and for all into approximately equal subtrees, one per thread, see inf::TreeSplitter.
+        work_stealing, ///< Each thread owns a deque of nodes to explore, and idle threads steal the shallowest nodes of the other threads. See inf::TreeOpt.
+    };
+
+    static void log(inf::Optimizer::ThreadSchedule thread_schedule);
+
+    /*! \brief Describes in which order an inf::TreeOpt explores the nodes of the inf::EventTree
+     * \details This is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search`.
+     * Exploring the most promising nodes first yields a good score early, which then allows to prune more branches.
+     * The orders other than inf::Optimizer::NodeOrder::tree rely on the lower bounds of the branch-and-bound approach,
+     * and thus require inf::DualVector::StoreBounds::yes. */
+    enum class NodeOrder {
+        tree,        ///< The children of a node are explored in the order in which they are stored in the inf::EventTree.
+        lower_bound, ///< The children of a node are explored by increasing lower bound on the scores of their events.
+        best_first,  ///< On top of inf::Optimizer::NodeOrder::lower_bound, the top levels of the tree are explored best-first with a priority queue, see inf::TreeOpt. This requires inf::Optimizer::ThreadSchedule::work_stealing.
+    };
+
+    static void log(inf::Optimizer::NodeOrder node_order);
+
+    /*! \brief Describes how an inf::TreeOpt bounds the scores of the events below a node of the inf::EventTree
+     * \details This is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search` and with inf::DualVector::StoreBounds::yes. */
+    enum class LowerBound {
+        per_term, ///< Each term of the inner product is bounded separately, using the unknown outcome of the inflation parties below the node, see inf::DualVector::StoreBounds.
+        branched, ///< The inf::Optimizer::LowerBound::per_term bounds are computed for each outcome of the last inflation party, and their minimum is used, see inf::TreeOpt.
+    };
+
+    static void log(inf::Optimizer::LowerBound lower_bound);
+
+    /*! \brief Describes whether a cheap heuristic should look for an event scoring at most zero before the exact search of the inf::Optimizer
+     * \details This is only relevant with inf::Optimizer::StopMode::sat, in which any such event is enough: the exact search,
+     * i.e., inf::Optimizer::get_pre_solution(), is then only performed when the heuristic fails. See inf::Optimizer::optimize(). */
+    enum class PreOracle {
+        none,         ///< The exact search is performed every time.
+        local_search, ///< A randomized greedy coordinate descent is performed first, see inf::LocalSearch.
+    };
+
+    static void log(inf::Optimizer::PreOracle pre_oracle);
+
     /*! \brief To conveniently instantiate a subclass of inf::Optimizer
         \param search_mode This parameter defines which subclass should be called, i.e., inf::BruteForceOpt or inf::TreeOpt for now.
         \param constraints An optimizer gets access to an inf::ConstraintSet, which is typically used outside of the optimizer.
@@ -107,17 +161,30 @@ class Optimizer {
         through inf::ConstraintSet::get_marg_evaluators().
         \param symtree_io This parameter is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search`, see inf::EventTree::IO for more details.
         \param n_threads This parameter is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search`, see inf::TreeOpt for more details.
+        \param thread_schedule This parameter is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search`, see inf::Optimizer::ThreadSchedule.
+        \param node_order This parameter is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search`, see inf::Optimizer::NodeOrder.
+        \param lower_bound This parameter is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search`, see inf::Optimizer::LowerBound.
+        \param pre_oracle See inf::Optimizer::PreOracle.
+        \param n_processes This parameter is only relevant when `search_mode == inf::Optimizer::SearchMode::tree_search`: if it is larger than one,
+        the tree search is shared between this many worker processes of \p n_threads threads each, see inf::ShardedOpt.
         \return An adequate instance of a subclass of inf::Optimizer */
     static inf::Optimizer::Ptr get_optimizer(inf::Optimizer::SearchMode search_mode,
                                              inf::ConstraintSet::Ptr const &constraints,
                                              inf::EventTree::IO symtree_io,
-                                             Index n_threads);
-
-    /*! \brief This general constructor simply initializes the member `m_constraints`
+                                             Index n_threads,
+                                             inf::Optimizer::ThreadSchedule thread_schedule = inf::Optimizer::ThreadSchedule::work_stealing,
+                                             inf::Optimizer::NodeOrder node_order = inf::Optimizer::NodeOrder::tree,
+                                             inf::Optimizer::LowerBound lower_bound = inf::Optimizer::LowerBound::per_term,
+                                             inf::Optimizer::PreOracle pre_oracle = inf::Optimizer::PreOracle::none,
+                                             Index n_processes = 1);
+
+    /*! \brief This general constructor simply initializes the members `m_constraints` and `m_local_search`
         \param constraints An optimizer gets access to an inf::ConstraintSet, which is typically used outside of the optimizer.
         This parameter allows to forward the inf::Inflation at hand, but also the current value of the inf::DualVector to optimize
-        through inf::ConstraintSet::get_marg_evaluators(). */
-    Optimizer(inf::ConstraintSet::Ptr const &constraints);
+        through inf::ConstraintSet::get_marg_evaluators().
+        \param pre_oracle See inf::Optimizer::PreOracle. */
+    Optimizer(inf::ConstraintSet::Ptr const &constraints,
+              inf::Optimizer::PreOracle pre_oracle = inf::Optimizer::PreOracle::none);
     //! \cond ignore deleted
     Optimizer(inf::Optimizer const &other) = delete;
     Optimizer(inf::Optimizer &&other) = delete;
@@ -125,19 +192,29 @@ class Optimizer {
     Optimizer &operator=(inf::Optimizer &&other) = delete;
     //! \endcond
 
-    /*! \brief This method is in charge of producing the optimizer (depending on `m_stop_mode`, see inf::Optimizer::StopMode) and its score */
+    /*! \brief This method is in charge of producing the optimizer (depending on `m_stop_mode`, see inf::Optimizer::StopMode) and its score
+     * \details If `m_n_events > 1` and the subclass supports it, it also returns the next lowest-scoring events. */
     virtual inf::Optimizer::PreSolution get_pre_solution() = 0;
 
     /*! \brief This method invokes inf::Optimizer::get_pre_solution() and dresses up the solution
         \param stop_mode Updates `m_stop_mode` so that inf::Optimzier::get_pre_solution() can use it
+        \param n_events Updates `m_n_events`: the number of lowest-scoring distinct events to return from a single search, instead of just the optimizer.
+        With inf::Optimizer::StopMode::sat, the search may stop once \p n_events events with a score smaller or equal to zero are found.
+        This is only supported by inf::TreeOpt, the other subclasses return the optimizer only.
+        \param seed_events With inf::Optimizer::PreOracle::local_search and inf::Optimizer::StopMode::sat, the events from which the inf::LocalSearch starts,
+        typically the events stored by the inf::FrankWolfe algorithm. If the inf::LocalSearch finds events scoring at most zero, these are returned
+        without calling inf::Optimizer::get_pre_solution().
         \return The optimizer, its score, and extra context about the target inf::TargetDistr and inf::Inflation */
-    inf::Optimizer::Solution optimize(inf::Optimizer::StopMode stop_mode);
+    inf::Optimizer::Solution optimize(inf::Optimizer::StopMode stop_mode,
+                                      Index n_events = 1,
+                                      std::set<inf::Event> const &seed_events = {});
 
     /*! \brief Logs information about the inf::Optimizer to `util::logger`, this is meant to be called on initializing an inf::FeasProblem */
     virtual void log_info() const {}
 
-    /*! \brief Logs information about the optimization status, this is meant to be called regularly within the inf::FeasProblem */
-    virtual void log_status() const {}
+    /*! \brief Logs information about the optimization status, this is meant to be called regularly within the inf::FeasProblem
+     * \details The overrides should call this to log the status of the inf::LocalSearch, if any. */
+    virtual void log_status() const;
 
   protected:
     /*! \brief This parameter allows to forward the inf::Inflation at hand, but also the current value of the inf::DualVector to optimize
@@ -148,6 +225,13 @@ class Optimizer {
      * \details This is a member variable to be easily accessed by the child classes of inf::Optimizer.
      * Otherwise, if it was just a parameter of inf::Optimizer::get_pre_solution(), it would also need to be forwarded to all the other child functions. */
     inf::Optimizer::StopMode m_stop_mode;
+
+    /*! \brief The number of lowest-scoring events that inf::Optimizer::get_pre_solution() should return. This attribute is set by inf::Optimizer::optimize(). */
+    Index m_n_events;
+
+  private:
+    /*! \brief The heuristic run before inf::Optimizer::get_pre_solution() in sat mode, this is `nullptr` with inf::Optimizer::PreOracle::none */
+    inf::LocalSearch::UniquePtr m_local_search;
 };
 
 } // namespace inf
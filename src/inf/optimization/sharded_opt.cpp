@@ -0,0 +1,231 @@
+#include "sharded_opt.h"
+#include "../../util/logger.h"
+#include "tree_opt.h"
+
+// For std::sort
+#include <algorithm>
+// For std::string
+#include <string>
+
+// For fork, waitpid and _exit
+#include <sys/wait.h>
+#include <unistd.h>
+
+inf::ShardedOpt::ShardedOpt(inf::ConstraintSet::Ptr const &constraints,
+                            inf::EventTree::IO symtree_io,
+                            Index n_processes,
+                            Index n_threads,
+                            inf::Optimizer::NodeOrder node_order,
+                            inf::Optimizer::LowerBound lower_bound,
+                            inf::Optimizer::PreOracle pre_oracle)
+    : inf::Optimizer(constraints, pre_oracle),
+      m_symtree_io(symtree_io),
+      m_n_threads(n_threads),
+      m_node_order(node_order),
+      m_lower_bound(lower_bound),
+      // Initialized below
+      m_shards(nullptr),
+      m_workers{},
+      m_workers_n_target_distribution_updates(0),
+      m_n_leaves_effective(0) {
+
+    util::logger << "Constructing inf::ShardedOpt." << util::cr;
+
+    HARD_ASSERT_LT(Index(0), n_processes)
+    if (m_node_order == inf::Optimizer::NodeOrder::best_first)
+        THROW_ERROR("inf::ShardedOpt does not support inf::Optimizer::NodeOrder::best_first")
+
+    // The worker processes inherit the inf::EventTree, so it has to be obtained before forking them
+    m_shards = inf::TreeSplitter::get_path_partition(m_constraints->get_inflation()->get_symtree(m_symtree_io, m_n_threads), n_processes);
+
+    start_workers();
+}
+
+inf::ShardedOpt::~ShardedOpt() {
+    stop_workers();
+}
+
+inf::Optimizer::PreSolution inf::ShardedOpt::get_pre_solution() {
+    // The workers only know about the target distribution that the inf::ConstraintSet had when they were forked,
+    // and they were stopped if the previous search failed
+    if (m_workers.empty() or m_constraints->get_n_target_distribution_updates() != m_workers_n_target_distribution_updates) {
+        // Each worker constructs an inf::TreeOpt, which resets its copy of inf::Optimizer::total_optimization_chrono: this requires it to be paused.
+        // Like the construction of the inf::ShardedOpt, restarting the workers is then not counted as optimization time.
+        inf::Optimizer::total_optimization_chrono.pause();
+        stop_workers();
+        start_workers();
+        inf::Optimizer::total_optimization_chrono.start();
+    }
+
+    inf::Optimizer::ScoredEvents scored_events;
+    try {
+        scored_events = search_with_workers();
+    } catch (...) {
+        // The other workers may still have answers pending, and a failed worker does not answer anymore, so the next search forks them anew
+        stop_workers();
+        throw;
+    }
+
+    HARD_ASSERT_LT(Index(0), scored_events.size())
+
+    // The m_n_events best events are among the m_n_events best events of each shard
+    std::sort(scored_events.begin(), scored_events.end());
+    if (scored_events.size() > m_n_events)
+        scored_events.resize(m_n_events);
+
+    return inf::Optimizer::PreSolution(scored_events.front().first,
+                                       scored_events.front().second,
+                                       inf::Optimizer::ScoredEvents(scored_events.begin() + 1, scored_events.end()));
+}
+
+inf::Optimizer::ScoredEvents inf::ShardedOpt::search_with_workers() {
+    inf::Quovec const quovec = m_constraints->get_quovec();
+
+    // All the requests are sent before any answer is awaited, so that the workers search in parallel
+    for (inf::ShardedOpt::Worker const &worker : m_workers) {
+        worker.channel->write(m_stop_mode);
+        worker.channel->write(m_n_events);
+        worker.channel->write_vector(quovec);
+    }
+
+    inf::Optimizer::ScoredEvents scored_events;
+    m_n_leaves_effective = 0;
+
+    for (inf::ShardedOpt::Worker const &worker : m_workers) {
+        bool success = false;
+        if (not worker.channel->read(success))
+            THROW_ERROR("A worker process of inf::ShardedOpt stopped unexpectedly")
+
+        if (not success) {
+            std::vector<char> error_message;
+            if (not worker.channel->read_vector(error_message))
+                THROW_ERROR("A worker process of inf::ShardedOpt stopped unexpectedly")
+            THROW_ERROR("A worker process of inf::ShardedOpt failed: " + std::string(error_message.begin(), error_message.end()))
+        }
+
+        Index n_leaves_effective = 0;
+        Index n_scored_events = 0;
+        if (not worker.channel->read(n_leaves_effective) or not worker.channel->read(n_scored_events))
+            THROW_ERROR("A worker process of inf::ShardedOpt stopped unexpectedly")
+        m_n_leaves_effective += n_leaves_effective;
+
+        for (Index i = 0; i < n_scored_events; ++i) {
+            Num score = 0;
+            inf::Event event;
+            if (not worker.channel->read(score) or not worker.channel->read_vector(event))
+                THROW_ERROR("A worker process of inf::ShardedOpt stopped unexpectedly")
+            scored_events.emplace_back(score, std::move(event));
+        }
+    }
+
+    return scored_events;
+}
+
+void inf::ShardedOpt::log_info() const {
+    util::logger << "The tree search is shared between " << m_shards->size() << " worker processes with "
+                 << m_n_threads << " threads each." << util::cr;
+}
+
+void inf::ShardedOpt::log_status() const {
+    inf::Optimizer::log_status();
+    if (m_n_leaves_effective > 0)
+        util::logger << "n_leaves = " << m_n_leaves_effective << ", ";
+}
+
+void inf::ShardedOpt::start_workers() {
+    HARD_ASSERT_TRUE(m_workers.empty())
+
+    for (std::vector<inf::TreeSplitter::Path> const &shard : *m_shards) {
+        std::pair<util::Channel::UniquePtr, util::Channel::UniquePtr> channels = util::Channel::get_local_pair();
+
+        // Otherwise, the pending output would be printed by the worker as well
+        util::logger << util::flush;
+
+        pid_t const pid = fork();
+        if (pid < 0)
+            THROW_ERROR("Could not fork a worker process for inf::ShardedOpt")
+
+        if (pid == 0) {
+            // The worker only keeps its own end of its own socket
+            channels.first.reset();
+            for (inf::ShardedOpt::Worker &worker : m_workers)
+                worker.channel.reset();
+
+            run_worker(shard, *channels.second);
+        }
+
+        m_workers.push_back(inf::ShardedOpt::Worker{pid, std::move(channels.first)});
+    }
+
+    m_workers_n_target_distribution_updates = m_constraints->get_n_target_distribution_updates();
+}
+
+void inf::ShardedOpt::stop_workers() {
+    for (inf::ShardedOpt::Worker &worker : m_workers) {
+        // The worker exits once it notices that its socket was closed
+        worker.channel.reset();
+        waitpid(worker.pid, nullptr, 0);
+    }
+
+    m_workers.clear();
+}
+
+void inf::ShardedOpt::run_worker(std::vector<inf::TreeSplitter::Path> const &shard, util::Channel &channel) {
+    int exit_status = 0;
+
+    // The coordinator reports the status of the search
+    util::logger.disable_dots_for_hidden_sections();
+    util::logger.set_log_level(0);
+    util::logger << util::begin_section;
+
+    try {
+        inf::TreeOpt tree_opt(m_constraints,
+                              m_symtree_io,
+                              m_n_threads,
+                              inf::Optimizer::ThreadSchedule::work_stealing,
+                              m_node_order,
+                              m_lower_bound);
+        tree_opt.set_shard(shard);
+
+        inf::Optimizer::StopMode stop_mode = inf::Optimizer::StopMode::opt;
+        Index n_events = 0;
+        inf::Quovec quovec;
+
+        while (channel.read(stop_mode)) {
+            if (not channel.read(n_events) or not channel.read_vector(quovec))
+                THROW_ERROR("The coordinator of inf::ShardedOpt stopped in the middle of a request")
+
+            m_constraints->set_dual_vector_from_quovec(quovec);
+            inf::Optimizer::Solution const sol = tree_opt.optimize(stop_mode, n_events);
+
+            channel.write(true);
+            channel.write(tree_opt.get_n_leaves_effective());
+            channel.write(static_cast<Index>(1 + sol.get_other_scored_events().size()));
+            channel.write(sol.get_inflation_event_score());
+            channel.write_vector(sol.get_inflation_event());
+            for (inf::Optimizer::ScoredEvent const &scored_event : sol.get_other_scored_events()) {
+                channel.write(scored_event.first);
+                channel.write_vector(scored_event.second);
+            }
+        }
+    } catch (std::exception const &e) {
+        exit_status = 1;
+
+        // The coordinator rethrows the error, see inf::ShardedOpt::get_pre_solution()
+        try {
+            std::string const error_message = e.what();
+            channel.write(false);
+            channel.write_vector(std::vector<char>(error_message.begin(), error_message.end()));
+
+            // The coordinator may still be sending a request, which would fail if the socket was already closed
+            char byte = 0;
+            while (channel.read(byte)) {
+            }
+        } catch (std::exception const &) {
+            // The coordinator is gone, there is no one left to report to
+        }
+    }
+
+    // Exit without running the destructors of the objects of the coordinator, which the worker inherited
+    _exit(exit_status);
+}
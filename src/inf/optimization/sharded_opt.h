@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../events/tree_splitter.h"
+#include "optimizer.h"
+#include "../../util/channel.h"
+
+// For pid_t
+#include <sys/types.h>
+
+/*! \file */
+
+namespace inf {
+
+/*! \ingroup opt
+ * \brief This inf::Optimizer shares the tree search of inf::TreeOpt between several worker processes
+ * \details This allows to use more cores than a single process would, the search of each process being itself multithreaded.
+ * The inf::EventTree is split with inf::TreeSplitter into one shard per process, i.e., a list of inf::TreeSplitter::Path
+ * whose subtrees have approximately the same number of leaves, and each worker process runs an inf::TreeOpt restricted
+ * to its shard (see inf::TreeOpt::set_shard()).
+ *
+ * The inf::ShardedOpt acts as the coordinator: on each call to inf::ShardedOpt::get_pre_solution(), it sends the current quovec
+ * (see inf::ConstraintSet::get_quovec()) to each worker through a util::Channel, and merges the inf::Optimizer::ScoredEvents that they send back.
+ * The messages exchanged are as follows:
+ * - To a worker: the inf::Optimizer::StopMode, the number of events requested, and the quovec.
+ * - From a worker: `true`, its number of effective leaves, then the number of its scored events followed by each score and event.
+ *   If the search of the worker throws, it instead sends `false` followed by the error message, which the coordinator rethrows.
+ *
+ * The workers are forked from the coordinator process, and communicate with it through Unix-domain sockets.
+ * They thus inherit the inf::EventTree of the coordinator, which is shared rather than copied as long as it is not written to,
+ * and the pages of a symmetrized event tree read from disk are in any case shared by all processes mapping it (see util::MappedFile).
+ * Since util::Channel only sees a connected socket, workers running on other hosts could be reached with TCP sockets instead,
+ * provided that they construct the same inf::ConstraintSet and inf::TreeOpt.
+ *
+ * A worker also inherits the target distribution of the inf::ConstraintSet at the time it is forked. When the target distribution changes
+ * (see inf::ConstraintSet::get_n_target_distribution_updates()), the workers are thus stopped and forked anew.
+ *
+ * Each worker prunes its own shard with its own minimum: the workers do not share their best scores during a search,
+ * and in sat mode, the coordinator waits for every worker to stop. */
+class ShardedOpt : public inf::Optimizer {
+  public:
+    /*! \brief Builds the inf::EventTree, splits it into \p n_processes shards and forks one worker process per shard
+     * \param constraints The relevant set of inf::Constraint defining the inner products \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist}\f$.
+     * \param symtree_io How to obtain the reduced set of inflation events \f$\redinfevents\f$, see inf::EventTree::IO.
+     * \param n_processes The number of worker processes.
+     * \param n_threads The number of threads of each worker process.
+     * \param node_order In which order each worker explores the nodes, see inf::Optimizer::NodeOrder. inf::Optimizer::NodeOrder::best_first is not supported.
+     * \param lower_bound How each worker bounds the scores below a node, see inf::Optimizer::LowerBound.
+     * \param pre_oracle Whether the coordinator runs a heuristic before the tree search in sat mode, see inf::Optimizer::PreOracle. */
+    ShardedOpt(inf::ConstraintSet::Ptr const &constraints,
+               inf::EventTree::IO symtree_io,
+               Index n_processes,
+               Index n_threads,
+               inf::Optimizer::NodeOrder node_order,
+               inf::Optimizer::LowerBound lower_bound,
+               inf::Optimizer::PreOracle pre_oracle = inf::Optimizer::PreOracle::none);
+    //! \cond
+    ShardedOpt(ShardedOpt const &) = delete;
+    ShardedOpt(ShardedOpt &&) = delete;
+    ShardedOpt &operator=(ShardedOpt const &) = delete;
+    ShardedOpt &operator=(ShardedOpt &&) = delete;
+    //! \endcond
+    /*! \brief Stops the worker processes */
+    ~ShardedOpt();
+
+    inf::Optimizer::PreSolution get_pre_solution() override;
+
+    void log_info() const override;
+
+    void log_status() const override;
+
+  private:
+    /*! \brief A worker process as seen by the coordinator */
+    struct Worker {
+        /*! \brief The process identifier of the worker */
+        pid_t pid;
+        /*! \brief The coordinator end of the socket connected to the worker */
+        util::Channel::UniquePtr channel;
+    };
+
+    /*! \brief How to obtain the reduced set of inflation events \f$\redinfevents\f$, see inf::EventTree::IO */
+    inf::EventTree::IO const m_symtree_io;
+    /*! \brief The number of threads of each worker process */
+    Index const m_n_threads;
+    /*! \brief In which order each worker explores the nodes */
+    inf::Optimizer::NodeOrder const m_node_order;
+    /*! \brief How each worker bounds the scores below a node */
+    inf::Optimizer::LowerBound const m_lower_bound;
+    /*! \brief The shard of each worker process, see inf::TreeOpt::set_shard() */
+    inf::TreeSplitter::PathPartitionConstPtr m_shards;
+    /*! \brief The running worker processes, one per element of `m_shards`
+     * \details This is empty after a failed search, the workers being then forked anew by the next search. */
+    std::vector<inf::ShardedOpt::Worker> m_workers;
+    /*! \brief The value of inf::ConstraintSet::get_n_target_distribution_updates() when `m_workers` were forked */
+    Index m_workers_n_target_distribution_updates;
+    /*! \brief The sum of the effective leaves reported by the workers in the last search, see inf::TreeOpt::get_n_leaves_effective() */
+    Index m_n_leaves_effective;
+
+    /*! \brief Forks one worker process per element of `m_shards` */
+    void start_workers();
+    /*! \brief Closes the sockets to the worker processes and waits for them to exit */
+    void stop_workers();
+    /*! \brief Sends the current quovec to every worker and gathers their scored events, unsorted
+     * \details This throws if a worker fails, in which case the workers have to be stopped since some answers may be left unread. */
+    inf::Optimizer::ScoredEvents search_with_workers();
+    /*! \brief The loop run by a worker process: it answers the requests received on \p channel until the coordinator closes it
+     * \details This never returns: the worker process exits at the end, without going back to the code of the coordinator. */
+    [[noreturn]] void run_worker(std::vector<inf::TreeSplitter::Path> const &shard, util::Channel &channel);
+};
+
+} // namespace inf
@@ -2,49 +2,81 @@
 #include "../../util/logger.h"
 #include "../../util/misc.h"
 #include "../events/tree_splitter.h"
-#include <future>
+// For std::sort and std::min_element
+#include <algorithm>
+// For std::greater
+#include <functional>
+// For std::iota
+#include <numeric>
 #include <thread>
 
+Index const inf::TreeOpt::global_minimum_refresh_period = 1024;
+Index const inf::TreeOpt::max_n_memo_subtrees = 4096;
+Num const inf::TreeOpt::unknown_lower_bound = std::numeric_limits<Num>::min();
+
 inf::TreeOpt::GlobalMinimum::GlobalMinimum()
     : m_global_minimum(std::numeric_limits<Num>::max()) {}
 
-void inf::TreeOpt::GlobalMinimum::set_if_smaller(Num score) {
-    // Here before attempting to write, we could check if we need to, but ok
-
-    // A std::unique_lock since only one thread can write to the global minimum at the same time
-    std::unique_lock<std::shared_mutex> lock(m_shared_mutex);
-    if (score < m_global_minimum)
-        m_global_minimum = score;
+Num inf::TreeOpt::GlobalMinimum::set_if_smaller(Num score) {
+    // An atomic fetch-min: on failure, compare_exchange_weak reloads current_minimum and we try again if score is still smaller
+    Num current_minimum = m_global_minimum.load(std::memory_order_relaxed);
+    while (score < current_minimum) {
+        if (m_global_minimum.compare_exchange_weak(current_minimum, score, std::memory_order_relaxed))
+            return score;
+    }
+    return current_minimum;
 }
 
 Num inf::TreeOpt::GlobalMinimum::get() const {
-    // A std::shared_lock since multiple threads can read the global minimum at the same time
-    std::shared_lock<std::shared_mutex> lock(m_shared_mutex);
-    return m_global_minimum;
+    // Only the value matters, it does not publish any other data
+    return m_global_minimum.load(std::memory_order_relaxed);
 }
 
-void inf::TreeOpt::GlobalMinimum::reset() {
-    std::unique_lock<std::shared_mutex> lock(m_shared_mutex);
-    m_global_minimum = std::numeric_limits<Num>::max();
+void inf::TreeOpt::GlobalMinimum::reset(Num global_minimum) {
+    m_global_minimum.store(global_minimum, std::memory_order_relaxed);
 }
 
 inf::TreeOpt::ThreadWorker::ThreadWorker(inf::Marginal::EvaluatorSet const &marg_evaluators)
     : marg_evaluators(marg_evaluators),
-      current_minimum(std::numeric_limits<Num>::max()),
-      current_best_event{},
+      best_scored_events{},
+      known_global_minimum(std::numeric_limits<Num>::max()),
+      n_nodes_before_refresh(0),
+      subtree_minima{},
+      subtree_index(0),
       last_depth_processed(0),
       queue{},
+      queue_lower_bounds{},
+      children{},
+      children_lower_bounds{},
+      leaf_outcomes{},
+      leaf_scores{},
+      queue_front(0),
       n_leaves_effective(0) {}
 
-inf::TreeOpt::ThreadReturn::ThreadReturn(inf::Optimizer::PreSolution &&pre_solution,
-                                         Index const n_leaves_effective)
-    : pre_solution(pre_solution),
-      n_leaves_effective(n_leaves_effective) {}
+void inf::TreeOpt::ThreadWorker::reset() {
+    best_scored_events = std::priority_queue<inf::Optimizer::ScoredEvent>();
+    known_global_minimum = std::numeric_limits<Num>::max();
+    n_nodes_before_refresh = 0;
+    std::fill(subtree_minima.begin(), subtree_minima.end(), std::numeric_limits<Num>::max());
+    subtree_index = 0;
+    queue.clear();
+    queue_lower_bounds.clear();
+    queue_front = 0;
+    n_leaves_effective = 0;
+}
+
+inf::TreeOpt::Task::Task(inf::EventTree::NodePos const &node_pos, inf::Event &&prefix)
+    : node_pos(node_pos),
+      prefix(std::move(prefix)) {}
 
 inf::TreeOpt::TreeOpt(inf::ConstraintSet::Ptr const &constraints,
                       inf::EventTree::IO symtree_io,
-                      Index n_threads)
-    : inf::Optimizer(constraints),
+                      Index n_threads,
+                      inf::Optimizer::ThreadSchedule thread_schedule,
+                      inf::Optimizer::NodeOrder node_order,
+                      inf::Optimizer::LowerBound lower_bound,
+                      inf::Optimizer::PreOracle pre_oracle)
+    : inf::Optimizer(constraints, pre_oracle),
 
       // Initialized below
       m_event_tree(nullptr),
@@ -52,9 +84,16 @@ inf::TreeOpt::TreeOpt(inf::ConstraintSet::Ptr const &constraints,
       m_symtree_io(symtree_io),
       m_marg_evaluators(m_constraints->get_marg_evaluators()),
       m_n_threads(n_threads),
+      m_thread_schedule(thread_schedule),
+      m_node_order(node_order),
+      m_lower_bound(lower_bound),
 
       // Initialized below
       m_path_partition(nullptr),
+      m_shard_tasks{},
+      m_task_deques(thread_schedule == inf::Optimizer::ThreadSchedule::work_stealing ? n_threads : 0),
+      m_n_idle_threads(0),
+      m_aborted(false),
 
       m_store_bounds(m_constraints->get_store_bounds() == inf::DualVector::StoreBounds::yes),
       m_inflation_n_parties(m_constraints->get_inflation()->get_n_parties()),
@@ -62,70 +101,366 @@ inf::TreeOpt::TreeOpt(inf::ConstraintSet::Ptr const &constraints,
 
       m_n_leaves_effective(0),
 
-      m_global_minimum() {
+      m_global_minimum(),
+
+      m_n_outcomes(m_constraints->get_inflation()->get_network()->get_n_outcomes()),
+      // Initialized below
+      m_memo_depth(0),
+      m_outcome_powers{},
+
+      m_previous_quovec{},
+      m_previous_n_target_distribution_updates(0),
+      m_previous_events{},
+      m_subtree_lower_bounds{},
+      m_max_score_change(0),
+      m_min_score(0),
+      m_score_threshold_seed(std::numeric_limits<Num>::max()),
+
+      m_thread_workers(n_threads, inf::TreeOpt::ThreadWorker(m_marg_evaluators)),
+      m_worker_pool(std::make_unique<util::WorkerPool>(n_threads, [this](Index thread_index) { thread_opt(thread_index); })) {
 
     util::logger << "Constructing inf::TreeOpt." << util::cr;
 
-    m_event_tree = &m_constraints->get_inflation()->get_symtree(m_symtree_io);
-    // NB: the path partition is trivial for one thread. This is implemented in inf::TreeSplitter.
-    m_path_partition = inf::TreeSplitter::get_path_partition(*m_event_tree, m_n_threads);
+    if (m_node_order != inf::Optimizer::NodeOrder::tree and not m_store_bounds)
+        THROW_ERROR("Ordering the nodes by lower bound requires inf::DualVector::StoreBounds::yes")
+    if (m_lower_bound != inf::Optimizer::LowerBound::per_term and not m_store_bounds)
+        THROW_ERROR("inf::Optimizer::LowerBound::branched requires inf::DualVector::StoreBounds::yes")
+    if (m_node_order == inf::Optimizer::NodeOrder::best_first and m_thread_schedule != inf::Optimizer::ThreadSchedule::work_stealing)
+        THROW_ERROR("inf::Optimizer::NodeOrder::best_first requires inf::Optimizer::ThreadSchedule::work_stealing")
+
+    m_event_tree = &m_constraints->get_inflation()->get_symtree(m_symtree_io, m_n_threads);
+    if (m_thread_schedule == inf::Optimizer::ThreadSchedule::static_split) {
+        // NB: the path partition is trivial for one thread. This is implemented in inf::TreeSplitter.
+        m_path_partition = inf::TreeSplitter::get_path_partition(*m_event_tree, m_n_threads);
+    }
+
+    // The subtrees are rooted at depth m_memo_depth-1 and the leaves are at depth m_inflation_n_parties-1:
+    // remembering the score of individual leaves would not save anything.
+    m_outcome_powers.push_back(1);
+    while (m_memo_depth + 1 < m_inflation_n_parties and m_outcome_powers.back() * m_n_outcomes <= max_n_memo_subtrees) {
+        ++m_memo_depth;
+        m_outcome_powers.push_back(m_outcome_powers.back() * m_n_outcomes);
+    }
+
+    for (inf::TreeOpt::ThreadWorker &thread_worker : m_thread_workers)
+        thread_worker.subtree_minima.resize(m_outcome_powers.back());
 }
 
 inf::Optimizer::PreSolution inf::TreeOpt::get_pre_solution() {
     m_n_leaves_effective = 0;
-    m_global_minimum.reset();
 
-    if (m_n_threads == 1) {
-        inf::TreeOpt::ThreadReturn thread_ret = thread_opt((*m_path_partition)[0]);
+    update_previous_quovec();
 
-        m_n_leaves_effective = thread_ret.n_leaves_effective;
+    inf::Optimizer::ScoredEvents const previous_scored_events = rescore_previous_events();
+    m_score_threshold_seed = std::numeric_limits<Num>::max();
 
-        return thread_ret.pre_solution;
-    }
+    if (previous_scored_events.size() >= m_n_events) {
+        Num const previous_score = previous_scored_events[m_n_events - 1].first;
 
-    std::vector<std::future<inf::TreeOpt::ThreadReturn>> futures;
-    futures.reserve(m_n_threads);
+        // In sat mode, the previous events may well be enough to conclude
+        if (m_stop_mode == inf::Optimizer::StopMode::sat and previous_score <= 0) {
+            // Nothing was learned about the subtrees for the current quovec
+            m_subtree_lower_bounds.clear();
+            return inf::Optimizer::PreSolution(previous_scored_events.front().first,
+                                               previous_scored_events.front().second,
+                                               inf::Optimizer::ScoredEvents(previous_scored_events.begin() + 1,
+                                                                            previous_scored_events.begin() + m_n_events));
+        }
 
-    for (Index const thread_index : util::Range(m_n_threads)) {
-        futures.push_back(std::async(std::launch::async,
-                                     &inf::TreeOpt::thread_opt,
-                                     this,
-                                     (*m_path_partition)[thread_index]));
+        m_score_threshold_seed = previous_score + 1;
     }
 
-    std::unique_ptr<inf::Optimizer::PreSolution> global_sol = nullptr;
+    m_global_minimum.reset(m_n_events == 1 ? m_score_threshold_seed : std::numeric_limits<Num>::max());
+
+    for (inf::TreeOpt::ThreadWorker &thread_worker : m_thread_workers)
+        thread_worker.reset();
+
+    if (m_thread_schedule == inf::Optimizer::ThreadSchedule::work_stealing) {
+        // An aborted search may have left some tasks behind
+        for (inf::TreeOpt::TaskDeque &task_deque : m_task_deques)
+            task_deque.tasks.clear();
+
+        if (m_node_order == inf::Optimizer::NodeOrder::best_first) {
+            get_best_first_tasks();
+        } else if (not m_shard_tasks.empty()) {
+            for (Index const i : util::Range(m_shard_tasks.size()))
+                m_task_deques[i % m_n_threads].tasks.push_back(m_shard_tasks[i]);
+        } else {
+            // Deal the root children to the threads, they will then steal from each other as needed
+            inf::EventTree::NodePos::Queue const root_children = m_event_tree->get_root_children_queue();
+            for (Index const i : util::Range(root_children.size()))
+                m_task_deques[i % m_n_threads].tasks.emplace_back(root_children[i], inf::Event{});
+        }
 
-    for (Index const thread_index : util::Range(m_n_threads)) {
+        m_n_idle_threads = 0;
+        m_aborted = false;
+    }
 
-        inf::TreeOpt::ThreadReturn const thread_ret = futures[thread_index].get();
+    try {
+        m_worker_pool->run();
+    } catch (...) {
+        // m_previous_quovec already moved on to the current quovec while m_subtree_lower_bounds still refer to an older one,
+        // so the next search must not rely on either
+        m_previous_quovec.clear();
+        m_subtree_lower_bounds.clear();
+        throw;
+    }
 
-        m_n_leaves_effective += thread_ret.n_leaves_effective;
+    inf::Optimizer::ScoredEvents scored_events;
 
-        Num const thread_score = thread_ret.pre_solution.inflation_event_score;
+    for (inf::TreeOpt::ThreadWorker &thread_worker : m_thread_workers) {
+        m_n_leaves_effective += thread_worker.n_leaves_effective;
 
-        if (global_sol == nullptr or thread_score < global_sol->inflation_event_score)
-            global_sol = std::make_unique<inf::Optimizer::PreSolution>(thread_ret.pre_solution);
+        for (; not thread_worker.best_scored_events.empty(); thread_worker.best_scored_events.pop())
+            scored_events.push_back(thread_worker.best_scored_events.top());
     }
 
-    HARD_ASSERT_EQUAL(global_sol->inflation_event_score, m_global_minimum.get())
+    // The m_n_events best events of all threads are among the m_n_events best events of each thread
+    std::sort(scored_events.begin(), scored_events.end());
+    if (scored_events.size() > m_n_events)
+        scored_events.resize(m_n_events);
+
+    HARD_ASSERT_EQUAL(scored_events.front().first, m_global_minimum.get())
+
+    // In sat mode, the threads may have stopped before exploring the whole tree
+    if (m_stop_mode == inf::Optimizer::StopMode::sat and scored_events.front().first <= 0) {
+        m_subtree_lower_bounds.clear();
+    } else {
+        m_subtree_lower_bounds.assign(m_outcome_powers.back(), std::numeric_limits<Num>::max());
+        for (inf::TreeOpt::ThreadWorker const &thread_worker : m_thread_workers) {
+            for (Index const i : util::Range(m_subtree_lower_bounds.size()))
+                m_subtree_lower_bounds[i] = std::min(m_subtree_lower_bounds[i], thread_worker.subtree_minima[i]);
+        }
+    }
 
-    return *global_sol;
+    m_previous_events.clear();
+    for (inf::Optimizer::ScoredEvent const &scored_event : scored_events)
+        m_previous_events.push_back(scored_event.second);
+
+    return inf::Optimizer::PreSolution(scored_events.front().first,
+                                       scored_events.front().second,
+                                       inf::Optimizer::ScoredEvents(scored_events.begin() + 1, scored_events.end()));
 }
 
 void inf::TreeOpt::log_info() const {
     util::logger << "The symmetrized events are stored as:" << util::cr;
     m_event_tree->log_info();
+    if (m_memo_depth > 0)
+        util::logger << "The lower bounds of the " << m_outcome_powers.back() << " subtrees at depth " << m_memo_depth - 1
+                     << " are reused from one search to the next." << util::cr;
 }
 
 void inf::TreeOpt::log_status() const {
+    inf::Optimizer::log_status();
     if (m_n_leaves_effective > 0)
         util::logger << "n_leaves = " << m_n_leaves_effective << ", ";
 }
 
-inf::TreeOpt::ThreadReturn inf::TreeOpt::thread_opt(std::vector<inf::TreeSplitter::Path> const &paths) {
-    // Initialization of the worker. Don't forget to reset it if we reuse them in the future!
-    inf::TreeOpt::ThreadWorker thread_worker(m_marg_evaluators);
+void inf::TreeOpt::set_shard(std::vector<inf::TreeSplitter::Path> const &shard) {
+    if (m_thread_schedule != inf::Optimizer::ThreadSchedule::work_stealing)
+        THROW_ERROR("inf::TreeOpt::set_shard() requires inf::Optimizer::ThreadSchedule::work_stealing")
+    if (m_node_order == inf::Optimizer::NodeOrder::best_first)
+        THROW_ERROR("inf::TreeOpt::set_shard() does not support inf::Optimizer::NodeOrder::best_first")
+
+    m_shard_tasks.clear();
+    for (inf::TreeSplitter::Path const &path : shard) {
+        HARD_ASSERT_LT(Index(0), path.size())
+
+        inf::Event prefix;
+        for (Index const depth : util::Range(path.size() - 1))
+            prefix.push_back(m_event_tree->get_outcome(inf::EventTree::NodePos(depth, path[depth])));
+
+        m_shard_tasks.emplace_back(inf::EventTree::NodePos(path.size() - 1, path.back()), std::move(prefix));
+    }
+
+    // The previous search may have explored other nodes
+    m_previous_quovec.clear();
+}
+
+Index inf::TreeOpt::get_n_leaves_effective() const {
+    return m_n_leaves_effective;
+}
+
+void inf::TreeOpt::update_previous_quovec() {
+    inf::Quovec const quovec = m_constraints->get_quovec();
+    Index const n_target_distribution_updates = m_constraints->get_n_target_distribution_updates();
 
+    if (m_previous_quovec.empty() or n_target_distribution_updates != m_previous_n_target_distribution_updates) {
+        m_previous_events.clear();
+        m_subtree_lower_bounds.clear();
+    } else {
+        inf::Quovec quovec_change(quovec.size());
+        for (Index const i : util::Range(quovec.size()))
+            quovec_change[i] = quovec[i] - m_previous_quovec[i];
+
+        m_max_score_change = m_constraints->get_max_inner_product(quovec_change);
+    }
+
+    m_min_score = -m_constraints->get_max_inner_product(quovec);
+    m_previous_quovec = quovec;
+    m_previous_n_target_distribution_updates = n_target_distribution_updates;
+}
+
+Num inf::TreeOpt::evaluate_lower_bound(inf::TreeOpt::ThreadWorker &thread_worker, Index depth, Num score_threshold) const {
+    Num const per_term_bound = thread_worker.marg_evaluators.evaluate_dual_vector();
+
+    // Branching on the child outcomes would amount to exploring the children
+    if (m_lower_bound == inf::Optimizer::LowerBound::per_term or depth + 2 >= m_inflation_n_parties or per_term_bound >= score_threshold)
+        return per_term_bound;
+
+    thread_worker.leaf_outcomes.resize(m_n_outcomes);
+    std::iota(thread_worker.leaf_outcomes.begin(), thread_worker.leaf_outcomes.end(), inf::Outcome(0));
+    thread_worker.marg_evaluators.evaluate_dual_vector_for_outcomes(m_inflation_n_parties - 1, thread_worker.leaf_outcomes, thread_worker.leaf_scores);
+
+    // Fixing the last party can only tighten each term, so this is at least `per_term_bound`, and it is returned even if the node is not pruned
+    // since inf::Optimizer::NodeOrder::lower_bound and inf::Optimizer::NodeOrder::best_first order the nodes by it
+    return *std::min_element(thread_worker.leaf_scores.begin(), thread_worker.leaf_scores.end());
+}
+
+inf::Optimizer::ScoredEvents inf::TreeOpt::rescore_previous_events() {
+    inf::Optimizer::ScoredEvents scored_events;
+    // The outcomes of this worker are set again before exploring any node
+    inf::Marginal::EvaluatorSet &marg_evaluators = m_thread_workers[0].marg_evaluators;
+
+    for (inf::Event const &event : m_previous_events) {
+        for (Index const depth : util::Range(m_inflation_n_parties))
+            marg_evaluators.set_outcome(depth, event[depth]);
+
+        scored_events.emplace_back(marg_evaluators.evaluate_dual_vector(), event);
+    }
+
+    std::sort(scored_events.begin(), scored_events.end());
+
+    return scored_events;
+}
+
+Index inf::TreeOpt::get_subtree_index(inf::Event const &event, Index depth_bound) const {
+    Index subtree_index = 0;
+    for (Index const depth : util::Range(depth_bound))
+        subtree_index += event[depth] * m_outcome_powers[depth];
+
+    return subtree_index;
+}
+
+void inf::TreeOpt::record_lower_bound(inf::TreeOpt::ThreadWorker &thread_worker, Index depth, Num lower_bound) const {
+    if (depth + 1 >= m_memo_depth) {
+        Num &subtree_minimum = thread_worker.subtree_minima[thread_worker.subtree_index];
+        subtree_minimum = std::min(subtree_minimum, lower_bound);
+    } else {
+        // The subtrees below the node are those whose first depth+1 outcomes are those of the node
+        Index const first_subtree_index = get_subtree_index(thread_worker.marg_evaluators.get_inflation_event(), depth + 1);
+        for (Index const i : util::Range(m_outcome_powers[m_memo_depth - depth - 1])) {
+            Num &subtree_minimum = thread_worker.subtree_minima[first_subtree_index + i * m_outcome_powers[depth + 1]];
+            subtree_minimum = std::min(subtree_minimum, lower_bound);
+        }
+    }
+}
+
+void inf::TreeOpt::get_best_first_tasks() {
+    inf::TreeOpt::ThreadWorker &thread_worker = m_thread_workers[0];
+    Index const frontier_depth = m_memo_depth > 0 ? m_memo_depth - 1 : 0;
+
+    // The nodes that were not pruned, together with the outcomes leading to them
+    std::vector<inf::TreeOpt::Task> nodes;
+    // The lower bound of each node of nodes together with its index, the lowest lower bound on top
+    std::priority_queue<std::pair<Num, Index>, std::vector<std::pair<Num, Index>>, std::greater<std::pair<Num, Index>>> best_nodes;
+    // The indices in nodes of the nodes at depth frontier_depth, by increasing lower bound
+    std::vector<Index> frontier;
+
+    // The children of the last node expanded, and the outcomes leading to them
+    inf::EventTree::NodePos::Queue children = m_event_tree->get_root_children_queue();
+    inf::Event prefix{};
+    // The outcomes were all set by inf::TreeOpt::rescore_previous_events()
+    Index last_depth_set = m_inflation_n_parties - 1;
+
+    while (true) {
+        for (inf::EventTree::NodePos const &child : children) {
+            for (Index const depth : util::Range(child.depth))
+                thread_worker.marg_evaluators.set_outcome(depth, prefix[depth]);
+            thread_worker.marg_evaluators.set_outcome(child.depth, m_event_tree->get_outcome(child));
+            for (Index depth(child.depth + 1); depth <= last_depth_set; ++depth)
+                thread_worker.marg_evaluators.set_outcome(depth, m_outcome_unknown);
+            last_depth_set = child.depth;
+
+            Num const score_lower_bound = evaluate_lower_bound(thread_worker, child.depth, m_score_threshold_seed);
+
+            // The nodes at depth frontier_depth are pruned in inf::TreeOpt::go_down_from(), which also knows about m_subtree_lower_bounds
+            if (child.depth < frontier_depth and score_lower_bound >= m_score_threshold_seed) {
+                record_lower_bound(thread_worker, child.depth, score_lower_bound);
+                thread_worker.n_leaves_effective += 1;
+            } else {
+                best_nodes.emplace(score_lower_bound, nodes.size());
+                nodes.emplace_back(child, inf::Event(prefix));
+            }
+        }
+
+        while (not best_nodes.empty() and nodes[best_nodes.top().second].node_pos.depth == frontier_depth) {
+            frontier.push_back(best_nodes.top().second);
+            best_nodes.pop();
+        }
+
+        if (best_nodes.empty())
+            break;
+
+        inf::TreeOpt::Task const &best_node = nodes[best_nodes.top().second];
+        best_nodes.pop();
+
+        children.clear();
+        m_event_tree->add_children_to_queue(children, best_node.node_pos);
+        prefix = best_node.prefix;
+        prefix.push_back(m_event_tree->get_outcome(best_node.node_pos));
+    }
+
+    // Each thread takes its tasks from the back of its deque, so the most promising tasks go last
+    for (Index i = frontier.size(); i-- > 0;)
+        m_task_deques[i % m_n_threads].tasks.push_back(nodes[frontier[i]]);
+}
+
+void inf::TreeOpt::add_children_to_queue(inf::TreeOpt::ThreadWorker &thread_worker, inf::EventTree::NodePos const &node_pos) const {
+    // Evaluating the lower bound of a leaf amounts to exploring it
+    if (m_node_order == inf::Optimizer::NodeOrder::tree or node_pos.depth + 2 >= m_inflation_n_parties) {
+        m_event_tree->add_children_to_queue(thread_worker.queue, node_pos);
+        thread_worker.queue_lower_bounds.resize(thread_worker.queue.size(), unknown_lower_bound);
+        return;
+    }
+
+    thread_worker.children.clear();
+    thread_worker.children_lower_bounds.clear();
+    m_event_tree->add_children_to_queue(thread_worker.children, node_pos);
+
+    Index const child_depth = node_pos.depth + 1;
+    for (Index const i : util::Range(thread_worker.children.size())) {
+        thread_worker.marg_evaluators.set_outcome(child_depth, m_event_tree->get_outcome(thread_worker.children[i]));
+        thread_worker.children_lower_bounds.emplace_back(evaluate_lower_bound(thread_worker, child_depth, get_score_threshold(thread_worker)), i);
+    }
+    // Such that inf::TreeOpt::go_down_from() resets this outcome when needed
+    thread_worker.last_depth_processed = child_depth;
+
+    // The last child pushed to the stack is explored first
+    std::sort(thread_worker.children_lower_bounds.begin(), thread_worker.children_lower_bounds.end(), std::greater<std::pair<Num, Index>>());
+    for (std::pair<Num, Index> const &child_lower_bound : thread_worker.children_lower_bounds) {
+        thread_worker.queue.push_back(thread_worker.children[child_lower_bound.second]);
+        thread_worker.queue_lower_bounds.push_back(child_lower_bound.first);
+    }
+}
+
+void inf::TreeOpt::thread_opt(Index thread_index) {
+    inf::TreeOpt::ThreadWorker &thread_worker = m_thread_workers[thread_index];
+
+    try {
+        if (m_thread_schedule == inf::Optimizer::ThreadSchedule::work_stealing)
+            explore_tasks(thread_worker, thread_index);
+        else
+            explore_paths(thread_worker, (*m_path_partition)[thread_index]);
+    } catch (...) {
+        // The exception is rethrown by util::WorkerPool::run() once the other threads are done
+        m_aborted = true;
+        throw;
+    }
+}
+
+void inf::TreeOpt::explore_paths(inf::TreeOpt::ThreadWorker &thread_worker,
+                                 std::vector<inf::TreeSplitter::Path> const &paths) {
     for (inf::TreeSplitter::Path const &path : paths) {
         Index const end_of_path = path.size() - 1;
 
@@ -136,11 +471,11 @@ inf::TreeOpt::ThreadReturn inf::TreeOpt::thread_opt(std::vector<inf::TreeSplitte
 
                 if (depth < end_of_path) {
                     // Set the first outcomes according to the path
-                    inf::EventTree::Node const &the_node = m_event_tree->get_node(node_pos);
-                    thread_worker.marg_evaluators.set_outcome(depth, the_node.outcome);
+                    thread_worker.marg_evaluators.set_outcome(depth, m_event_tree->get_outcome(node_pos));
                 } else if (depth == end_of_path) {
                     // Init queue with a single node to be processed below
                     thread_worker.queue = inf::EventTree::NodePos::Queue({node_pos});
+                    thread_worker.queue_lower_bounds = std::vector<Num>({unknown_lower_bound});
                 }
             } else { // depth > end_of_path
                 // If we don't store the bounds, we don't care about the end of the event being initialized to "?"
@@ -151,24 +486,137 @@ inf::TreeOpt::ThreadReturn inf::TreeOpt::thread_opt(std::vector<inf::TreeSplitte
             }
         }
 
+        if (end_of_path >= m_memo_depth)
+            thread_worker.subtree_index = get_subtree_index(thread_worker.marg_evaluators.get_inflation_event(), m_memo_depth);
+
         while (not thread_worker.queue.empty()) {
             inf::EventTree::NodePos const node_pos = util::pop_back(thread_worker.queue);
-            go_down_from(thread_worker, node_pos);
+            go_down_from(thread_worker, node_pos, util::pop_back(thread_worker.queue_lower_bounds));
+        }
+    }
+}
+
+void inf::TreeOpt::explore_tasks(inf::TreeOpt::ThreadWorker &thread_worker, Index thread_index) {
+    for (std::unique_ptr<inf::TreeOpt::Task> task = get_task(thread_index);
+         task != nullptr;
+         task = get_task(thread_index)) {
+
+        Index const task_depth = task->node_pos.depth;
+
+        for (Index const depth : util::Range(m_inflation_n_parties)) {
+            if (depth < task_depth) {
+                // Restore the outcomes leading to the node of the task
+                thread_worker.marg_evaluators.set_outcome(depth, task->prefix[depth]);
+            } else if (depth > task_depth) {
+                // If we don't store the bounds, we don't care about the end of the event being initialized to "?"
+                if (not m_store_bounds)
+                    break;
+                else
+                    thread_worker.marg_evaluators.set_outcome(depth, m_outcome_unknown);
+            }
+        }
+
+        if (task_depth >= m_memo_depth)
+            thread_worker.subtree_index = get_subtree_index(task->prefix, m_memo_depth);
+
+        thread_worker.queue = inf::EventTree::NodePos::Queue({task->node_pos});
+        thread_worker.queue_lower_bounds = std::vector<Num>({unknown_lower_bound});
+        thread_worker.queue_front = 0;
+
+        while (thread_worker.queue.size() > thread_worker.queue_front) {
+            share_work(thread_worker, thread_index);
+
+            inf::EventTree::NodePos const node_pos = util::pop_back(thread_worker.queue);
+            go_down_from(thread_worker, node_pos, util::pop_back(thread_worker.queue_lower_bounds));
+        }
+    }
+}
+
+std::unique_ptr<inf::TreeOpt::Task> inf::TreeOpt::get_task(Index thread_index) {
+    if (m_aborted)
+        return nullptr;
+
+    {
+        inf::TreeOpt::TaskDeque &own_deque = m_task_deques[thread_index];
+        std::lock_guard<std::mutex> const lock(own_deque.mutex);
+
+        if (not own_deque.tasks.empty()) {
+            std::unique_ptr<inf::TreeOpt::Task> task = std::make_unique<inf::TreeOpt::Task>(own_deque.tasks.back());
+            own_deque.tasks.pop_back();
+            return task;
         }
     }
 
-    return inf::TreeOpt::ThreadReturn(inf::Optimizer::PreSolution(thread_worker.current_minimum,
-                                                                  thread_worker.current_best_event),
-                                      thread_worker.n_leaves_effective);
+    ++m_n_idle_threads;
+
+    while (true) {
+        for (Index const offset : util::Range(Index(1), m_n_threads)) {
+            inf::TreeOpt::TaskDeque &victim_deque = m_task_deques[(thread_index + offset) % m_n_threads];
+            std::lock_guard<std::mutex> const lock(victim_deque.mutex);
+
+            if (not victim_deque.tasks.empty()) {
+                std::unique_ptr<inf::TreeOpt::Task> task = std::make_unique<inf::TreeOpt::Task>(victim_deque.tasks.front());
+                victim_deque.tasks.pop_front();
+                // This must happen before releasing the lock: otherwise, all threads could look idle while this task is being explored
+                --m_n_idle_threads;
+                return task;
+            }
+        }
+
+        // Only busy threads add tasks, so if no thread is busy, there is nothing left to do
+        if (m_n_idle_threads == m_n_threads or m_aborted)
+            return nullptr;
+
+        std::this_thread::yield();
+    }
+}
+
+void inf::TreeOpt::share_work(inf::TreeOpt::ThreadWorker &thread_worker, Index thread_index) {
+    // Keep at least one node for the thread itself
+    if (m_n_idle_threads.load(std::memory_order_relaxed) == 0 or thread_worker.queue.size() < thread_worker.queue_front + 2)
+        return;
+
+    inf::EventTree::NodePos const &node_pos = thread_worker.queue[thread_worker.queue_front];
+
+    // A leaf is not worth the synchronization
+    if (node_pos.depth == m_inflation_n_parties - 1)
+        return;
+
+    inf::TreeOpt::TaskDeque &own_deque = m_task_deques[thread_index];
+    std::lock_guard<std::mutex> const lock(own_deque.mutex);
+
+    // Only share one task at a time, the next one will be shared once this one has been stolen
+    if (not own_deque.tasks.empty())
+        return;
+
+    inf::Event const &inflation_event = thread_worker.marg_evaluators.get_inflation_event();
+    inf::Event prefix;
+    prefix.reserve(node_pos.depth);
+    for (Index const depth : util::Range(node_pos.depth))
+        prefix.push_back(inflation_event[depth]);
+
+    own_deque.tasks.emplace_back(node_pos, std::move(prefix));
+    ++thread_worker.queue_front;
 }
 
 void inf::TreeOpt::go_down_from(inf::TreeOpt::ThreadWorker &thread_worker,
-                                inf::EventTree::NodePos const &node_pos) {
+                                inf::EventTree::NodePos const &node_pos,
+                                Num known_lower_bound) {
+
+    if (thread_worker.n_nodes_before_refresh == 0) {
+        thread_worker.known_global_minimum = m_global_minimum.get();
+        thread_worker.n_nodes_before_refresh = global_minimum_refresh_period;
+    }
+    --thread_worker.n_nodes_before_refresh;
+
+    Num const score_threshold = get_score_threshold(thread_worker);
 
     // In sat mode, as soon as the global minimum is <= 0, we stop minimizing.
     // In particular, the <= 0 score may be found in a differen thread.
-    if (m_stop_mode == inf::Optimizer::StopMode::sat and m_global_minimum.get() <= 0) {
+    // When several events are requested, a thread stops once it found enough of them with a score <= 0.
+    if (m_stop_mode == inf::Optimizer::StopMode::sat and score_threshold <= 0) {
         thread_worker.queue.clear();
+        thread_worker.queue_lower_bounds.clear();
         return;
     }
 
@@ -181,22 +629,46 @@ void inf::TreeOpt::go_down_from(inf::TreeOpt::ThreadWorker &thread_worker,
         thread_worker.last_depth_processed = node_pos.depth;
     }
 
-    inf::EventTree::Node const &the_node = m_event_tree->get_node(node_pos);
-    thread_worker.marg_evaluators.set_outcome(node_pos.depth, the_node.outcome);
+    thread_worker.marg_evaluators.set_outcome(node_pos.depth, m_event_tree->get_outcome(node_pos));
+
+    if (node_pos.depth + 1 == m_memo_depth) {
+        thread_worker.subtree_index = get_subtree_index(thread_worker.marg_evaluators.get_inflation_event(), m_memo_depth);
+
+        // The scores of the previous search can only have changed by m_max_score_change
+        if (not m_subtree_lower_bounds.empty()) {
+            Num const previous_lower_bound = m_subtree_lower_bounds[thread_worker.subtree_index];
+            Num const score_lower_bound = previous_lower_bound == std::numeric_limits<Num>::max()
+                                              ? previous_lower_bound
+                                              : std::max(previous_lower_bound - m_max_score_change, m_min_score);
+
+            if (score_lower_bound >= score_threshold) {
+                record_lower_bound(thread_worker, node_pos.depth, score_lower_bound);
+                thread_worker.n_leaves_effective += 1;
+                return;
+            }
+        }
+    }
 
     // if we're not at the last depth
     if (node_pos.depth < m_inflation_n_parties - 1) {
         bool keep_branch = true;
 
         if (m_store_bounds) {
-            Num const score_lower_bound = thread_worker.marg_evaluators.evaluate_dual_vector();
+            Num const score_lower_bound = known_lower_bound != unknown_lower_bound
+                                              ? known_lower_bound
+                                              : evaluate_lower_bound(thread_worker, node_pos.depth, score_threshold);
 
             // We keep the branch only if the lower bound suggests that there is a chance to do strictly better than the current minimum
-            keep_branch = (score_lower_bound < m_global_minimum.get());
+            keep_branch = (score_lower_bound < score_threshold);
+
+            if (not keep_branch)
+                record_lower_bound(thread_worker, node_pos.depth, score_lower_bound);
         }
 
-        if (keep_branch)
-            m_event_tree->add_children_to_queue(thread_worker.queue, node_pos);
+        if (keep_branch and node_pos.depth + 2 == m_inflation_n_parties)
+            explore_leaves(thread_worker, node_pos);
+        else if (keep_branch)
+            add_children_to_queue(thread_worker, node_pos);
         else
             thread_worker.n_leaves_effective += 1;
 
@@ -204,12 +676,71 @@ void inf::TreeOpt::go_down_from(inf::TreeOpt::ThreadWorker &thread_worker,
     {
         thread_worker.n_leaves_effective += 1;
         Num const score = thread_worker.marg_evaluators.evaluate_dual_vector();
+        record_lower_bound(thread_worker, node_pos.depth, score);
+
+        if (score < score_threshold) {
+            thread_worker.best_scored_events.emplace(score, thread_worker.marg_evaluators.get_inflation_event());
+            if (thread_worker.best_scored_events.size() > m_n_events)
+                thread_worker.best_scored_events.pop();
 
-        if (score < m_global_minimum.get()) {
-            thread_worker.current_minimum = score;
-            thread_worker.current_best_event = thread_worker.marg_evaluators.get_inflation_event();
+            thread_worker.known_global_minimum = m_global_minimum.set_if_smaller(score);
+        }
+    }
+}
+
+void inf::TreeOpt::explore_leaves(inf::TreeOpt::ThreadWorker &thread_worker, inf::EventTree::NodePos const &node_pos) {
+    ASSERT_EQUAL(node_pos.depth + 2, m_inflation_n_parties)
+
+    Index const leaf_depth = node_pos.depth + 1;
 
-            m_global_minimum.set_if_smaller(score);
+    thread_worker.children.clear();
+    m_event_tree->add_children_to_queue(thread_worker.children, node_pos);
+
+    thread_worker.leaf_outcomes.clear();
+    for (inf::EventTree::NodePos const &child : thread_worker.children)
+        thread_worker.leaf_outcomes.push_back(m_event_tree->get_outcome(child));
+
+    thread_worker.marg_evaluators.evaluate_dual_vector_for_outcomes(leaf_depth, thread_worker.leaf_outcomes, thread_worker.leaf_scores);
+
+    Index const n_leaves = thread_worker.leaf_outcomes.size();
+    for (Index i(0); i < n_leaves; ++i) {
+        // Same bookkeeping as in inf::TreeOpt::go_down_from(), which would have been called on each leaf
+        if (thread_worker.n_nodes_before_refresh == 0) {
+            thread_worker.known_global_minimum = m_global_minimum.get();
+            thread_worker.n_nodes_before_refresh = global_minimum_refresh_period;
+        }
+        --thread_worker.n_nodes_before_refresh;
+
+        Num const score_threshold = get_score_threshold(thread_worker);
+
+        if (m_stop_mode == inf::Optimizer::StopMode::sat and score_threshold <= 0) {
+            thread_worker.queue.clear();
+            thread_worker.queue_lower_bounds.clear();
+            return;
+        }
+
+        thread_worker.n_leaves_effective += 1;
+        Num const score = thread_worker.leaf_scores[i];
+        record_lower_bound(thread_worker, leaf_depth, score);
+
+        if (score < score_threshold) {
+            inf::Event event = thread_worker.marg_evaluators.get_inflation_event();
+            event[leaf_depth] = thread_worker.leaf_outcomes[i];
+
+            thread_worker.best_scored_events.emplace(score, std::move(event));
+            if (thread_worker.best_scored_events.size() > m_n_events)
+                thread_worker.best_scored_events.pop();
+
+            thread_worker.known_global_minimum = m_global_minimum.set_if_smaller(score);
         }
     }
 }
+
+Num inf::TreeOpt::get_score_threshold(inf::TreeOpt::ThreadWorker const &thread_worker) const {
+    if (m_n_events == 1)
+        return thread_worker.known_global_minimum;
+    else if (thread_worker.best_scored_events.size() < m_n_events)
+        return m_score_threshold_seed;
+    else
+        return thread_worker.best_scored_events.top().first;
+}
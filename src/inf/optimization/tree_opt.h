@@ -3,8 +3,16 @@
 #include "../events/event_tree.h"
 #include "../events/tree_splitter.h"
 #include "optimizer.h"
+#include "../../util/worker_pool.h"
 
-#include <shared_mutex>
+// For std::atomic
+#include <atomic>
+// For std::deque
+#include <deque>
+// For std::mutex
+#include <mutex>
+// For std::priority_queue
+#include <queue>
 
 namespace inf {
 
@@ -25,58 +33,128 @@ namespace inf {
  *   current minimum, then we can discard (prune) this branch. This has proven to be extremely efficient for "random" initial inf::DualVector that the inf::FeasProblem
  *   start with, but as the inf::DualVector becomes more and more fine-tuned to try to prove that an inf::TargetDistr is incompatible with an inf::Inflation,
  *   this branch-and-bound approach becomes less useful.
- * - The tree search can be parallelized by specifying a number of threads. Using inf::TreeSplitter, the inf::EventTree is then split into approximately equal (in terms of number of leaves)
- *   subtrees, and each subtree is investigated in parallel to find its local minimum. When combined with the branch-and-bound approach, each thread informs the other threads of its best current
+ * - The lower bound of the branch-and-bound approach evaluates each term of the inner product at the marginal events containing unknown outcomes "?", which bounds
+ *   each term separately (see inf::DualVector::StoreBounds). Several terms involving the same unknown inflation party may however not reach their bounds for the same outcome.
+ *   With inf::Optimizer::LowerBound::branched, the bound is instead the minimum, over the outcomes of the last inflation party, of the bounds obtained with that party set to that outcome
+ *   (see inf::TreeOpt::evaluate_lower_bound()). This costs up to \f$\nouts\f$ more evaluations per node, but the last party is the one that remains unknown in the whole subtree.
+ * - With the branch-and-bound approach, the earlier a good score is found, the more branches are pruned. The order in which the nodes are explored
+ *   is controlled by inf::Optimizer::NodeOrder:
+ *   - With inf::Optimizer::NodeOrder::lower_bound, the lower bounds of the children of a node are evaluated when the node is expanded, and the children are
+ *     explored by increasing lower bound. The lower bound of each child is stored next to it in inf::TreeOpt::ThreadWorker::queue_lower_bounds, so that it is
+ *     not evaluated a second time. The children at the last depth are left in the order of the inf::EventTree, since evaluating them amounts to exploring them.
+ *   - With inf::Optimizer::NodeOrder::best_first, the nodes above depth `inf::TreeOpt::m_memo_depth - 1` are first explored best-first, i.e., always expanding the
+ *     node with the lowest lower bound from a priority queue (see inf::TreeOpt::get_best_first_tasks()). The nodes at depth `inf::TreeOpt::m_memo_depth - 1` are then
+ *     handed to the threads as inf::TreeOpt::Task, the most promising ones first, and explored as with inf::Optimizer::NodeOrder::lower_bound.
+ * - The tree search can be parallelized by specifying a number of threads. When combined with the branch-and-bound approach, each thread informs the other threads of its best current
  *   minimum, such that the lower bounds on the local scores can be compared with the global minimum, potentially pruning many more branches.
+ *   The work is shared between the threads according to inf::Optimizer::ThreadSchedule:
+ *   - With inf::Optimizer::ThreadSchedule::static_split, the inf::EventTree is split using inf::TreeSplitter into approximately equal (in terms of number of leaves)
+ *     subtrees, and each subtree is investigated in parallel to find its local minimum. Since the pruning is not uniform accross the tree, some threads may finish long before the others.
+ *   - With inf::Optimizer::ThreadSchedule::work_stealing, each thread owns an inf::TreeOpt::TaskDeque. A busy thread that notices idle threads moves the shallowest node of its
+ *     search stack to its inf::TreeOpt::TaskDeque, together with the outcomes of the parties above that node (see inf::TreeOpt::Task), and idle threads steal these nodes.
+ *     This keeps all threads busy until the last leaf, and works for any number of threads.
+ *   The global minimum is a lock-free atomic, and each thread compares its scores with its own copy of it, which is refreshed every
+ *   inf::TreeOpt::global_minimum_refresh_period nodes (see inf::TreeOpt::ThreadWorker::known_global_minimum).
+ *   The threads and their inf::TreeOpt::ThreadWorker are created once in the constructor (see util::WorkerPool), since the tree search is typically
+ *   performed at every Frank-Wolfe iteration: each call to inf::TreeOpt::get_pre_solution() then merely wakes them up.
+ * - Successive calls to inf::TreeOpt::get_pre_solution() typically minimize similar dual vectors, and each search starts from what the previous one learned:
+ *   - The events returned by the previous search are re-scored with the new dual vector. Their scores bound the minimum from above, so they seed the
+ *     threshold that the branch-and-bound compares with, rather than starting from the largest ::Num. In sat mode, if they already score <= 0, the search is skipped.
+ *   - Each search records a lower bound on the score of the events in each subtree rooted at depth inf::TreeOpt::m_memo_depth (see inf::TreeOpt::m_subtree_lower_bounds).
+ *     The score of an event changes by at most inf::ConstraintSet::get_max_inner_product() applied to the change of quovec, so the next search
+ *     can discard a whole subtree whose corrected lower bound is not better than the threshold, without evaluating anything in it.
  * */
 class TreeOpt : public inf::Optimizer {
   public:
     /*! \brief This is the shared data between threads, storing the global smallest value found so far, and providing a thread-safe interface
      * \details Although we use this structure even without the branch-and-bound mechanism, it is really
      * only useful with the branch-and-bound approach. Indeed, without brach-and-bound, each thread
-     * could simply compute it's own minimum, and we can then take the global minimum once every thread is finished. */
+     * could simply compute it's own minimum, and we can then take the global minimum once every thread is finished.
+     *
+     * The global minimum is a `std::atomic` rather than a value protected by a mutex, so that reading it is a plain load
+     * and the threads do not contend for a lock. */
     class GlobalMinimum {
       public:
         /*! \brief Initializes `m_global_minimum` to the largest ::Num */
         GlobalMinimum();
 
-        /*! \brief Sets `m_global_minimum = min(m_global_minimum, score)` in a thread-safe manner */
-        void set_if_smaller(Num score);
+        /*! \brief Sets `m_global_minimum = min(m_global_minimum, score)` in a thread-safe manner
+         * \return The value of `m_global_minimum` after the update, which may be smaller than \p score if another thread did better */
+        Num set_if_smaller(Num score);
         /*! \brief Gets the current value of `m_global_minimum` in a thread-safe manner */
         Num get() const;
-        /*! \brief Reset `m_global_minimum` to the largest ::Num */
-        void reset();
+        /*! \brief Reset `m_global_minimum` to \p global_minimum, the largest ::Num by default
+         * \details This must not be called while threads are optimizing. */
+        void reset(Num global_minimum = std::numeric_limits<Num>::max());
 
       private:
         /*! \brief The current global minimum accross all threads */
-        Num m_global_minimum;
-        /*! \brief This mutex allows threads to know when they are allowed to access `m_global_minimum`
-         * \details This is `mutable` since we need to change its state in the `const` method inf::TreeOpt::GlobalMinimum::get(). */
-        mutable std::shared_mutex m_shared_mutex;
+        std::atomic<Num> m_global_minimum;
     };
 
+    /*! \brief The number of nodes after which a inf::TreeOpt::ThreadWorker refreshes inf::TreeOpt::ThreadWorker::known_global_minimum */
+    static Index const global_minimum_refresh_period;
+
+    /*! \brief The maximal number of subtrees whose lower bounds are remembered from one search to the next, see inf::TreeOpt::m_subtree_lower_bounds */
+    static Index const max_n_memo_subtrees;
+
+    /*! \brief The value of inf::TreeOpt::ThreadWorker::queue_lower_bounds for the nodes whose lower bound has not been evaluated yet */
+    static Num const unknown_lower_bound;
+
     /*! \brief This struct encapsulates the data that each thread works with
-     * \details This allows in particular to conveniently initialize the storage of each thread is a single struct instantiation. */
+     * \details This allows in particular to conveniently initialize the storage of each thread is a single struct instantiation.
+     * Each thread keeps its inf::TreeOpt::ThreadWorker from one call of inf::TreeOpt::get_pre_solution() to the next:
+     * `marg_evaluators` only refers to the inf::DualVector, so that it remains valid when the latter is updated. */
     struct ThreadWorker {
         /*! \brief The \p marg_evaluators allow the inf::TreeOpt::ThreadWorker to evaluate the underlying inf::DualVector,
          * i.e., to evaluate the underlying inner products \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist}\f$. */
         ThreadWorker(inf::Marginal::EvaluatorSet const &marg_evaluators);
 
+        /*! \brief Prepares the inf::TreeOpt::ThreadWorker for a new tree search
+         * \details The outcomes stored in `marg_evaluators` are left as they are, since they are set before exploring any node. */
+        void reset();
+
         /*! \brief To allow the inf::TreeOpt::ThreadWorker to evaluate the underlying inf::DualVector,
          * i.e., to evaluate the underlying inner products \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist}\f$. */
         inf::Marginal::EvaluatorSet marg_evaluators;
-        /*! \brief The current best (i.e., minimum) score found by the thread
-         * \details The idea is that each thread stores the current minimum it discovered itself,
+        /*! \brief The best (i.e., lowest) scores found by the thread, together with the corresponding events
+         * \details This is a max-heap holding at most inf::Optimizer::m_n_events elements, so that its top is the score to beat to enter it.
+         * The idea is that each thread stores the current minimum it discovered itself,
          * together with the corresponding best event. It should be true at the end of the optimization that the
          * best current minimum of all threads equals the global minimum, which is asserted */
-        Num current_minimum;
-        /*! \brief %Inflation event corresponding to the score of `inf::TreeOpt::CurrentMinimum::current_minimum` */
-        inf::Event current_best_event;
+        std::priority_queue<inf::Optimizer::ScoredEvent> best_scored_events;
+        /*! \brief The copy of inf::TreeOpt::GlobalMinimum that the thread compares its scores with
+         * \details This is at least the actual global minimum: it is refreshed every inf::TreeOpt::global_minimum_refresh_period nodes,
+         * and whenever the thread improves on it. A stale value only means that the thread prunes a bit less. */
+        Num known_global_minimum;
+        /*! \brief The number of nodes left before the next refresh of `known_global_minimum` */
+        Index n_nodes_before_refresh;
+        /*! \brief The lower bounds on the scores of each subtree found by the thread, see inf::TreeOpt::m_subtree_lower_bounds */
+        std::vector<Num> subtree_minima;
+        /*! \brief The index in `subtree_minima` of the subtree containing the nodes currently explored
+         * \details This is set on reaching depth `inf::TreeOpt::m_memo_depth - 1`, see inf::TreeOpt::get_subtree_index(). */
+        Index subtree_index;
         /*! \brief This stores the last depth of the tree that was processed, allowing to reset the outcomes stored in `inf::TreeOpt::CurrentMinimum::marg_evaluators`
          * to the unknown outcome */
         Index last_depth_processed;
         /*! \brief The stack of fill requests to be processed in inf::TreeOpt::go_down_from() */
         inf::EventTree::NodePos::Queue queue;
+        /*! \brief `queue_lower_bounds[i]` is the lower bound on the scores of the events below `queue[i]`, or inf::TreeOpt::unknown_lower_bound if it was not evaluated yet
+         * \details This always has the same size as `queue`. The lower bounds are only evaluated in advance with inf::Optimizer::NodeOrder::lower_bound
+         * or inf::Optimizer::NodeOrder::best_first, see inf::TreeOpt::add_children_to_queue(). */
+        std::vector<Num> queue_lower_bounds;
+        /*! \brief Scratch space for inf::TreeOpt::add_children_to_queue(), holding the children of a node */
+        inf::EventTree::NodePos::Queue children;
+        /*! \brief Scratch space for inf::TreeOpt::add_children_to_queue(), holding the lower bound of each child together with its index in `children` */
+        std::vector<std::pair<Num, Index>> children_lower_bounds;
+        /*! \brief Scratch space for inf::TreeOpt::explore_leaves() and inf::TreeOpt::evaluate_lower_bound(), holding outcomes of the last inflation party */
+        std::vector<inf::Outcome> leaf_outcomes;
+        /*! \brief Scratch space for inf::TreeOpt::explore_leaves() and inf::TreeOpt::evaluate_lower_bound(), holding the score of each element of `leaf_outcomes` */
+        std::vector<Num> leaf_scores;
+        /*! \brief The elements `queue[0], ..., queue[queue_front-1]` have been given away to other threads and must not be explored
+         * \details Since `queue` is a stack, its front holds the shallowest nodes, which are the ones worth giving away.
+         * This is only used with inf::Optimizer::ThreadSchedule::work_stealing, see inf::TreeOpt::share_work(). */
+        Index queue_front;
         /*! \brief The number of leaves perceived thanks to the branch-and-bound approach
          * \details If the \p constraints passed to inf::TreeOpt::TreeOpt() have `constraints.get_store_bounds == inf::DualVector::StoreBounds::no`,
          * then `n_leaves_effective` will just be the number of leaves of the subtree that the inf::TreeOpt::ThreadWorker considers.
@@ -87,27 +165,45 @@ class TreeOpt : public inf::Optimizer {
         Index n_leaves_effective;
     };
 
-    /*! \brief This is what each thread returns, essentially an inf::Optimizer::PreSolution
-     * \details The overall solution will then be the minimum of the solutions of the different threads. */
-    struct ThreadReturn {
-        /*! \param pre_solution The minimum inner product score obtained by the thread
-         * \param n_leaves_effective The number of leaves perceived thanks to the branch-and-bound approach, see inf::TreeOpt::ThreadWorker::n_leaves_effective. */
-        ThreadReturn(inf::Optimizer::PreSolution &&pre_solution, Index const n_leaves_effective);
-
-        /*! \brief The inf::Optimizer::PreSolution holding the minimum score and the corresponding optimizer inflation event
-         * found by the thread */
-        inf::Optimizer::PreSolution const pre_solution;
-        /*! \brief See inf::TreeOpt::ThreadWorker::n_leaves_effective */
-        Index const n_leaves_effective;
+    /*! \brief A node of the inf::EventTree that can be explored independently by any thread
+     * \details This is used with inf::Optimizer::ThreadSchedule::work_stealing. */
+    struct Task {
+        /*! \param node_pos The node to explore
+         * \param prefix The outcomes of the inflation parties at depths `0, ..., node_pos.depth-1` leading to \p node_pos */
+        Task(inf::EventTree::NodePos const &node_pos, inf::Event &&prefix);
+
+        /*! \brief The node to explore */
+        inf::EventTree::NodePos const node_pos;
+        /*! \brief The outcomes of the inflation parties at depths `0, ..., node_pos.depth-1` leading to `node_pos`
+         * \details This is the state that an inf::TreeOpt::ThreadWorker::marg_evaluators must be brought to before exploring `node_pos`. */
+        inf::Event const prefix;
+    };
+
+    /*! \brief The inf::TreeOpt::Task owned by a thread, which the other threads can steal
+     * \details The owner thread takes its tasks from the back, and the other threads steal from the front.
+     * Since the owner only adds tasks to its deque while it is busy, the deque of an idle thread is always empty. */
+    struct TaskDeque {
+        /*! \brief Protects `tasks` */
+        std::mutex mutex;
+        /*! \brief The tasks waiting to be explored */
+        std::deque<inf::TreeOpt::Task> tasks;
     };
 
     /*! \brief Initialize with the relevant set of inf::Constraint, whether or not to read/write the inf::EventTree from disk, and the number of threads to use
      * \param constraints The relevant set of inf::Constraint defining the inner products \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist}\f$.
      * \param symtree_io How to obtain the reduced set of inflation events \f$\redinfevents\f$, see inf::EventTree::IO.
-     * \param n_threads The number of threads to use to accelerate the tree search. */
+     * \param n_threads The number of threads to use to accelerate the tree search.
+     * \param thread_schedule How to share the tree search between the threads, see inf::Optimizer::ThreadSchedule.
+     * \param node_order In which order to explore the nodes, see inf::Optimizer::NodeOrder.
+     * \param lower_bound How to bound the scores below a node, see inf::Optimizer::LowerBound.
+     * \param pre_oracle Whether to run a heuristic before the tree search in sat mode, see inf::Optimizer::PreOracle. */
     TreeOpt(inf::ConstraintSet::Ptr const &constraints,
             inf::EventTree::IO symtree_io,
-            Index n_threads);
+            Index n_threads,
+            inf::Optimizer::ThreadSchedule thread_schedule,
+            inf::Optimizer::NodeOrder node_order,
+            inf::Optimizer::LowerBound lower_bound,
+            inf::Optimizer::PreOracle pre_oracle = inf::Optimizer::PreOracle::none);
     //! \cond
     TreeOpt(TreeOpt const &) = delete;
     TreeOpt(TreeOpt &&) = delete;
@@ -121,6 +217,15 @@ class TreeOpt : public inf::Optimizer {
 
     void log_status() const override;
 
+    /*! \brief Restricts the tree search to the subtrees rooted at the ends of \p shard, see inf::ShardedOpt
+     * \details The paths are typically one element of the inf::TreeSplitter::PathPartition obtained with inf::TreeSplitter::get_path_partition().
+     * The nodes at the ends of the paths are dealt to the threads in place of the children of the root.
+     * This requires inf::Optimizer::ThreadSchedule::work_stealing and is not supported with inf::Optimizer::NodeOrder::best_first. */
+    void set_shard(std::vector<inf::TreeSplitter::Path> const &shard);
+
+    /*! \brief The number of leaves explored by the last tree search, see inf::TreeOpt::ThreadWorker::n_leaves_effective */
+    Index get_n_leaves_effective() const;
+
   private:
     /*! \brief The relevant set of inf::Constraint defining the inner products \f$\inner{\quovec}{\totconstraintmap(\detdistr\infevent)}_{\constraintlist}\f$ */
     inf::EventTree const *m_event_tree;
@@ -132,9 +237,26 @@ class TreeOpt : public inf::Optimizer {
     inf::Marginal::EvaluatorSet const m_marg_evaluators;
     /*! \brief The number of threads to use to accelerate the tree search. */
     Index const m_n_threads;
-    /*! \brief When `m_n_threads > 1`, this contains a partition of `m_event_tree` into `m_n_threads` approximately equal subtrees
+    /*! \brief How to share the tree search between the threads */
+    inf::Optimizer::ThreadSchedule const m_thread_schedule;
+    /*! \brief In which order to explore the nodes */
+    inf::Optimizer::NodeOrder const m_node_order;
+    /*! \brief How to bound the scores below a node */
+    inf::Optimizer::LowerBound const m_lower_bound;
+    /*! \brief With inf::Optimizer::ThreadSchedule::static_split, this contains a partition of `m_event_tree` into `m_n_threads` approximately equal subtrees
+     * \details This is `nullptr` with inf::Optimizer::ThreadSchedule::work_stealing.
      * \sa inf::TreeSplitter::get_path_partition() */
     inf::TreeSplitter::PathPartitionConstPtr m_path_partition;
+    /*! \brief The nodes that the tree search is restricted to, see inf::TreeOpt::set_shard(), this is empty if the whole tree is searched */
+    std::vector<inf::TreeOpt::Task> m_shard_tasks;
+    /*! \brief With inf::Optimizer::ThreadSchedule::work_stealing, `m_task_deques[thread_index]` holds the tasks of the thread `thread_index` */
+    std::vector<inf::TreeOpt::TaskDeque> m_task_deques;
+    /*! \brief With inf::Optimizer::ThreadSchedule::work_stealing, the number of threads that are looking for a task
+     * \details When this reaches `m_n_threads`, all the inf::TreeOpt::TaskDeque are empty and the tree search is over. */
+    std::atomic<Index> m_n_idle_threads;
+    /*! \brief With inf::Optimizer::ThreadSchedule::work_stealing, this is set when a thread throws, so that inf::TreeOpt::get_task() stops handing out tasks
+     * \details Otherwise, the throwing thread would never become idle and the other threads would wait for it forever. */
+    std::atomic<bool> m_aborted;
     /*! \brief This is `constraints.get_store_bounds() == inf::DualVector::StoreBounds::yes`, which is stored as a boolean for readability in this class code
      * \sa inf::ConstraintSet::get_store_bounds() */
     bool const m_store_bounds;
@@ -146,21 +268,106 @@ class TreeOpt : public inf::Optimizer {
     Index m_n_leaves_effective;
     /*! \brief The thread-safe readable/writable global minimum value shared by the threads */
     GlobalMinimum m_global_minimum;
-    /*! \brief This function is a single-threaded minimization
-     * \details It minimizes the inner products using inf::TreeOpt::m_marg_evaluators
+    /*! \brief The number \f$\nouts\f$ of outcomes per party */
+    inf::Outcome const m_n_outcomes;
+    /*! \brief The subtrees whose lower bounds are remembered are those rooted at depth `m_memo_depth - 1`, identified by the first `m_memo_depth` outcomes
+     * \details This is the largest depth smaller than \f$|\infparties|\f$ such that there are at most inf::TreeOpt::max_n_memo_subtrees such subtrees. */
+    Index m_memo_depth;
+    /*! \brief `m_outcome_powers[depth]` is \f$\nouts^{\text{depth}}\f$, for `depth = 0, ..., m_memo_depth` */
+    std::vector<Index> m_outcome_powers;
+    /*! \brief The quovec minimized by the previous search, see inf::ConstraintSet::get_quovec()
+     * \details This is empty if there was no previous search, or if it threw. */
+    inf::Quovec m_previous_quovec;
+    /*! \brief The value of inf::ConstraintSet::get_n_target_distribution_updates() during the previous search
+     * \details The previous search is only relevant if the target distribution did not change in between. */
+    Index m_previous_n_target_distribution_updates;
+    /*! \brief The events returned by the previous search */
+    std::vector<inf::Event> m_previous_events;
+    /*! \brief For each subtree rooted at depth `m_memo_depth - 1`, a lower bound on the scores of its events for `m_previous_quovec`
+     * \details The subtree whose first `m_memo_depth` outcomes are \f$o_0,o_1,\dots\f$ has index \f$o_0 + o_1 \nouts + \dots\f$, see inf::TreeOpt::get_subtree_index().
+     * This is empty if the previous search did not explore the whole tree. */
+    std::vector<Num> m_subtree_lower_bounds;
+    /*! \brief An upper bound on the change of the score of any event between `m_previous_quovec` and the current quovec */
+    Num m_max_score_change;
+    /*! \brief A lower bound on the score of any event for the current quovec, see inf::ConstraintSet::get_max_inner_product() */
+    Num m_min_score;
+    /*! \brief The threshold that the scores must beat before the inf::TreeOpt::ThreadWorker finds events of their own
+     * \details This is one more than the `m_n_events`-th smallest score of the re-scored `m_previous_events` (or the largest ::Num), so that
+     * the events scoring exactly this much are still found by the tree search. */
+    Num m_score_threshold_seed;
+    /*! \brief `m_thread_workers[thread_index]` is the inf::TreeOpt::ThreadWorker of the thread `thread_index`, each holding a copy of `m_marg_evaluators` */
+    std::vector<inf::TreeOpt::ThreadWorker> m_thread_workers;
+    /*! \brief The threads running inf::TreeOpt::thread_opt()
+     * \details This is declared last so that the threads are stopped before the members they use are destroyed. */
+    std::unique_ptr<util::WorkerPool> m_worker_pool;
+
+    /*! \brief Computes `m_max_score_change` and `m_min_score` for the current quovec, forgetting the previous search if it is not comparable anymore */
+    void update_previous_quovec();
+    /*! \brief The lower bound on the scores of the events below the node at depth \p depth whose outcomes are set in `thread_worker.marg_evaluators`
+     * \details With inf::Optimizer::LowerBound::branched, if the inf::Optimizer::LowerBound::per_term bound does not reach \p score_threshold, the last inflation party
+     * is set to each of its outcomes in turn and the smallest of the resulting bounds is returned. This is at least the inf::Optimizer::LowerBound::per_term bound,
+     * and it is returned even if it is below \p score_threshold, since the nodes are also ordered by it (see inf::Optimizer::NodeOrder).
+     * The outcome of the last party is set back to the unknown outcome afterwards. */
+    Num evaluate_lower_bound(inf::TreeOpt::ThreadWorker &thread_worker, Index depth, Num score_threshold) const;
+    /*! \brief Re-scores `m_previous_events` with the current inf::DualVector
+     * \return The re-scored events, by increasing score */
+    inf::Optimizer::ScoredEvents rescore_previous_events();
+    /*! \brief The index of the subtree containing \p event, using the first `depth_bound` outcomes only, see inf::TreeOpt::m_subtree_lower_bounds */
+    Index get_subtree_index(inf::Event const &event, Index depth_bound) const;
+    /*! \brief Records that the scores of the events below the node at depth \p depth currently explored by \p thread_worker are at least \p lower_bound
+     * \details If \p depth is smaller than `m_memo_depth - 1`, this concerns all the subtrees below that node. */
+    void record_lower_bound(inf::TreeOpt::ThreadWorker &thread_worker, Index depth, Num lower_bound) const;
+    /*! \brief With inf::Optimizer::NodeOrder::best_first, explores the top levels of the tree best-first and deals the nodes at depth `m_memo_depth - 1` to `m_task_deques`
+     * \details This is performed by the calling thread with `m_thread_workers[0]`, before the other threads start. The nodes are expanded by increasing lower bound
+     * using a priority queue, and the branches whose lower bound is not better than `m_score_threshold_seed` are pruned.
+     * Each inf::TreeOpt::TaskDeque receives the nodes of depth `m_memo_depth - 1` in the order in which they are found, the most promising one at the back. */
+    void get_best_first_tasks();
+    /*! \brief Adds the children of \p node_pos to `thread_worker.queue`, by decreasing lower bound if `m_node_order` asks for it, so that the most promising child is explored first
+     * \details This assumes that the inflation event of `thread_worker.marg_evaluators` is filled up to the depth of \p node_pos, and unknown below. */
+    void add_children_to_queue(inf::TreeOpt::ThreadWorker &thread_worker, inf::EventTree::NodePos const &node_pos) const;
+    /*! \brief This function is the single-threaded minimization performed by the thread \p thread_index
+     * \details It hands `m_thread_workers[thread_index]` to inf::TreeOpt::explore_paths() or inf::TreeOpt::explore_tasks()
+     * depending on `m_thread_schedule`. If these throw, `m_aborted` is set before rethrowing. */
+    void thread_opt(Index thread_index);
+    /*! \brief This function minimizes the inner products using `thread_worker.marg_evaluators`
      * over all inflation events of inf::TreeOpt::m_event_tree that are contained in the subtree described by \p paths.
-     * The parallelization is then performed by creating multiple threads running this function in parallel with different \p paths. */
-    inf::TreeOpt::ThreadReturn thread_opt(std::vector<inf::TreeSplitter::Path> const &paths);
+     * \details This is used with inf::Optimizer::ThreadSchedule::static_split, the parallelization then being performed by
+     * running this function in parallel with different \p paths. */
+    void explore_paths(inf::TreeOpt::ThreadWorker &thread_worker, std::vector<inf::TreeSplitter::Path> const &paths);
+    /*! \brief This function is the minimization performed by each thread with inf::Optimizer::ThreadSchedule::work_stealing
+     * \details It explores the tasks obtained from inf::TreeOpt::get_task() until there are none left in any thread. */
+    void explore_tasks(inf::TreeOpt::ThreadWorker &thread_worker, Index thread_index);
+    /*! \brief Returns the next task of the thread \p thread_index, stealing it from another thread if needed
+     * \return `nullptr` once all the threads are idle, meaning that the tree search is over, or once a thread has thrown (see `m_aborted`) */
+    std::unique_ptr<inf::TreeOpt::Task> get_task(Index thread_index);
+    /*! \brief If some threads are idle, moves the shallowest node of `thread_worker.queue` to `m_task_deques[thread_index]`
+     * \details The outcomes above that node are read from `thread_worker.marg_evaluators`: since `thread_worker.queue` is explored depth-first,
+     * the ancestors of any node still in the queue are the ones currently filled in the inflation event. */
+    void share_work(inf::TreeOpt::ThreadWorker &thread_worker, Index thread_index);
+    /*! \brief The score that a leaf must beat (strictly) to be of interest to \p thread_worker, and that a branch lower bound must beat to be explored
+     * \details With a single event requested, this is `thread_worker.known_global_minimum`, so that the threads benefit from each other's findings.
+     * With `m_n_events > 1`, this is the top of `thread_worker.best_scored_events` once it holds `m_n_events` events, and the largest ::Num before that. */
+    Num get_score_threshold(inf::TreeOpt::ThreadWorker const &thread_worker) const;
     /*! \brief This function investigates a single node of inf::TreeOpt::m_event_tree
      * \details This function assumes that \p thread_worker contains (within inf::TreeOpt::ThreadWorker::marg_evaluators)
      * a partially filled inflation event up to `node_pose.depth-1` included.
      * It then fills the outcome of the inflation event according to the node of inf::TreeOpt::m_event_tree at position `node_pos`.
      * Depending on inf::TreeOpt::m_store_bounds, if possible, it does nothing (meaning that the current branch is no good for minimization).
-     * Otherwise, it appends the children of \p node_pos to `thread_worker.queue` and returns.
+     * Otherwise, it appends the children of \p node_pos to `thread_worker.queue` and returns,
+     * unless these children are leaves, in which case they are explored right away with inf::TreeOpt::explore_leaves().
      * If \p node_pos is a terminal node of the inf::TreeOpt::m_event_tree, then it evaluates the inner product and calls
-     * inf::TreeOpt::GlobalMinimum::set_if_smaller() on inf::TreeOpt::m_global_minimum. */
+     * inf::TreeOpt::GlobalMinimum::set_if_smaller() on inf::TreeOpt::m_global_minimum.
+     * The comparisons use `thread_worker.known_global_minimum` rather than inf::TreeOpt::m_global_minimum.
+     * \param known_lower_bound The lower bound on the scores below \p node_pos if it was already evaluated, inf::TreeOpt::unknown_lower_bound otherwise,
+     * see inf::TreeOpt::ThreadWorker::queue_lower_bounds. */
     void go_down_from(inf::TreeOpt::ThreadWorker &thread_worker,
-                      inf::EventTree::NodePos const &node_pos);
+                      inf::EventTree::NodePos const &node_pos,
+                      Num known_lower_bound);
+    /*! \brief This function explores all the children of \p node_pos, which must be at depth `m_inflation_n_parties-2`, i.e., whose children are leaves
+     * \details This does what inf::TreeOpt::go_down_from() would do for each leaf, but the leaves are scored together with
+     * inf::Marginal::EvaluatorSet::evaluate_dual_vector_for_outcomes(): the marginal events that do not involve the last inflation party
+     * are looked up once for all siblings. The outcome of the last inflation party in `thread_worker.marg_evaluators` is left unchanged. */
+    void explore_leaves(inf::TreeOpt::ThreadWorker &thread_worker, inf::EventTree::NodePos const &node_pos);
 };
 
 } // namespace inf
@@ -39,6 +39,7 @@ void user::AppManager::parse_argv() {
             // do not carry over to the next application
             inf::FeasOptions::Ptr feas_options = std::make_shared<inf::FeasOptions>();
             feas_options->set_n_threads(m_inf_cli->get_n_threads());
+            feas_options->set_n_processes(m_inf_cli->get_n_processes());
             feas_options->set(m_inf_cli->get_symtree_io());
 
             application->set_inf_cli(m_inf_cli);
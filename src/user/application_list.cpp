@@ -20,8 +20,14 @@ std::vector<user::Application::Ptr> user::get_application_list() {
             std::make_shared<user::inflation_marginal>(),
             std::make_shared<user::inf_tree_filler>(),
             std::make_shared<user::dual_vector_bounds>(),
+            std::make_shared<user::arena_width>(),
+            std::make_shared<user::outcome_kernels>(),
             std::make_shared<user::dual_vector_io>(),
             std::make_shared<user::opt_bounds>(),
+            std::make_shared<user::opt_reuse>(),
+            std::make_shared<user::sharded_opt>(),
+            std::make_shared<user::local_search>(),
+            std::make_shared<user::party_order>(),
             std::make_shared<user::opt_time>(),
             std::make_shared<user::file_stream>(),
             std::make_shared<user::tree_splitter>(),
@@ -141,7 +141,7 @@ void print_some_events(inf::Inflation const &inflation) {
     while (not queue.empty()) {
 
         inf::EventTree::NodePos const node_pos = util::pop_back(queue);
-        working_event[node_pos.depth] = tree.get_node(node_pos).outcome;
+        working_event[node_pos.depth] = tree.get_outcome(node_pos);
 
         if (node_pos.depth < inflation.get_n_parties() - 1)
             tree.add_children_to_queue(queue, node_pos);
@@ -22,6 +22,8 @@
 #include "../../inf/frank_wolfe/pairwise_fw.h"
 #include "../../inf/inf_problem/inflation.h"
 #include "../../inf/inf_problem/tree_filler.h"
+#include "../../inf/inf_problem/vis_pb.h"
+#include "../../inf/optimization/local_search.h"
 #include "../../inf/optimization/optimizer.h"
 
 // For marginal tests
@@ -30,6 +32,10 @@
 
 // #include<cstdlib>
 #include <memory>
+// For std::numeric_limits
+#include <limits>
+// For std::set
+#include <set>
 
 namespace user {
 
@@ -90,6 +96,76 @@ Num dummy_eval_dual_vector_on_distribution(
     }
     return score;
 }
+
+inf::Optimizer::ScoredEvents get_scored_events(inf::Optimizer::Solution const &sol) {
+    inf::Optimizer::ScoredEvents scored_events = {inf::Optimizer::ScoredEvent(sol.get_inflation_event_score(), sol.get_inflation_event())};
+    scored_events.insert(scored_events.end(), sol.get_other_scored_events().begin(), sol.get_other_scored_events().end());
+    return scored_events;
+}
+
+// Checks that the events are distinct, sorted by increasing score, and that their scores are those of the current dual vector
+void check_scored_events(inf::ConstraintSet const &constraints, inf::Optimizer::ScoredEvents const &scored_events) {
+    inf::Marginal::EvaluatorSet evaluators = constraints.get_marg_evaluators();
+    std::set<inf::Event> distinct_events;
+
+    for (Index const i : util::Range(scored_events.size())) {
+        inf::Event const &event = scored_events[i].second;
+        for (Index const party : util::Range(event.size()))
+            evaluators.set_outcome(party, event[party]);
+        HARD_ASSERT_EQUAL(evaluators.evaluate_dual_vector(), scored_events[i].first)
+
+        HARD_ASSERT_TRUE(distinct_events.insert(event).second)
+        if (i > 0)
+            HARD_ASSERT_LTE(scored_events[i - 1].first, scored_events[i].first)
+    }
+}
+
+// The uniform distribution of the triangle network with n_outcomes outcomes per party
+inf::TargetDistr::ConstPtr get_uniform_triangle_distribution(inf::Outcome const n_outcomes) {
+    inf::Network::ConstPtr const network = inf::Network::create_triangle(n_outcomes);
+
+    inf::EventTensor d(network->get_n_parties(), network->get_n_outcomes());
+    d.set_denom(util::pow(Num(n_outcomes), Num(3)));
+    for (inf::Event const &e : network->get_event_range())
+        d.get_num(e) = 1;
+
+    return std::make_shared<inf::TargetDistr>("Uniform distribution with " + std::to_string(n_outcomes) + " outcomes",
+                                              "U" + std::to_string(n_outcomes), network, d);
+}
+
+// The largest quovec components that the arena stores with each inf::Marginal::EvaluatorSet::ArenaWidth,
+// for the constraint {"A00,B00,C00", "A11,B11,C11"} of the 2x2x2 inflation of d
+std::vector<std::pair<Num, inf::Marginal::EvaluatorSet::ArenaWidth>> get_arena_width_cases(inf::ConstraintSet const &constraints,
+                                                                                        inf::TargetDistr const &d) {
+    // The largest scale factor of the two sides of the constraint, as in user::test_dual_vector_eval()
+    Num const lhs_denom = util::factorial(2) * util::factorial(2) * util::factorial(2) / 2;
+    Num const rhs_denom = util::pow(d.get_event_tensor().get_denom(), Num(2));
+    Num const max_scale = std::max(lhs_denom, rhs_denom) / std::gcd(lhs_denom, rhs_denom);
+    HARD_ASSERT_LTE(max_scale, std::numeric_limits<std::int16_t>::max())
+
+    Num const mid_component = std::numeric_limits<std::int16_t>::max() / max_scale + 1;
+    // The components must be strictly smaller than inf::ConstraintSet::get_max_dual_vector_component() in absolute value
+    Num const max_component = constraints.get_max_dual_vector_component() - 1;
+    HARD_ASSERT_LTE(max_scale * mid_component, std::numeric_limits<std::int32_t>::max())
+    HARD_ASSERT_LT(std::numeric_limits<std::int32_t>::max(), max_scale * max_component)
+
+    return {
+        {1, inf::Marginal::EvaluatorSet::ArenaWidth::int16},
+        {mid_component, inf::Marginal::EvaluatorSet::ArenaWidth::int32},
+        {max_component, inf::Marginal::EvaluatorSet::ArenaWidth::int64},
+    };
+}
+
+// Sets a random dual vector whose first quovec component reaches -max_component, the others being small
+inf::Quovec set_random_quovec(inf::ConstraintSet &constraints, Num const max_component) {
+    util::RNG<Num> coeff_rng(-1, 1);
+    inf::Quovec quovec(constraints.get_quovec_size());
+    for (Num &coeff : quovec)
+        coeff = coeff_rng.get_rand();
+    quovec[0] = -max_component;
+    constraints.set_dual_vector_from_quovec(quovec);
+    return quovec;
+}
 //! \endcond
 
 } // namespace user
@@ -583,6 +659,29 @@ void user::event_tree::run() {
         }
     }
 
+    // Testing the inf::EventTree binary image
+    {
+        std::string const filename = "data/test_event_tree";
+
+        tree.write_image(filename, "metadata");
+
+        inf::EventTree other_tree(depth);
+        other_tree.read_image(filename, "metadata");
+
+        util::logger << util::cr << "The tree was saved as a binary image and mapped back, giving:" << util::cr;
+
+        other_tree.log_flat();
+        other_tree.log_info();
+
+        HARD_ASSERT_EQUAL(other_tree.get_n_leaves(), 7)
+
+        if (tree != other_tree) {
+            THROW_ERROR("The two trees are not equal")
+        } else {
+            util::logger << "The two trees are equal." << util::cr;
+        }
+    }
+
     util::logger << util::cr;
 }
 
@@ -623,6 +722,31 @@ void user::inf_tree_filler::run() {
         symtree.log_info();
 
         HARD_ASSERT_EQUAL(symtree.get_n_leaves(), expected_n_leaves[i])
+
+        // The multithreaded filling must give the exact same tree
+        for (Index n_threads : {2, 3}) {
+            inf::EventTree multithreaded_symtree(inflation->get_n_parties());
+            inf::TreeFiller::fill_tree(multithreaded_symtree, *inflation, n_threads);
+            if (not(multithreaded_symtree == symtree))
+                THROW_ERROR("The inf::EventTree filled with " + std::to_string(n_threads) + " threads differs from the sequential one")
+        }
+
+        // Checkpointing after every batch must not change the tree, and neither must resuming from the final checkpoint
+        {
+            std::string const checkpoint_filename = "data/test_tree_filler_checkpoint";
+            inf::TreeFiller::remove_checkpoint(checkpoint_filename);
+
+            inf::EventTree checkpointed_symtree(inflation->get_n_parties());
+            inf::TreeFiller::fill_tree(checkpointed_symtree, *inflation, 2, checkpoint_filename, 0.0);
+            HARD_ASSERT_TRUE(util::FileStream::exists(checkpoint_filename, util::FileStream::Format::text))
+
+            inf::EventTree resumed_symtree(inflation->get_n_parties());
+            inf::TreeFiller::fill_tree(resumed_symtree, *inflation, 1, checkpoint_filename, 0.0);
+            inf::TreeFiller::remove_checkpoint(checkpoint_filename);
+
+            if (not(checkpointed_symtree == symtree) or not(resumed_symtree == symtree))
+                THROW_ERROR("The checkpointed inf::EventTree differs from the sequential one")
+        }
     }
 
     util::logger << util::cr;
@@ -719,6 +843,87 @@ void user::dual_vector_bounds::run() {
     HARD_ASSERT_EQUAL(dual_vector.get_n_orbits_with_unknown(), 7)
 }
 
+void user::arena_width::run() {
+    inf::TargetDistr::ConstPtr d = user::get_noisy_srb(1, 2);
+    inf::Inflation::ConstPtr inflation = std::make_shared<const inf::Inflation>(d, inf::Inflation::Size{2, 2, 2});
+
+    inf::ConstraintSet constraints(inflation, {{"A00,B00,C00", "A11,B11,C11", {}}}, inf::DualVector::StoreBounds::yes);
+    constraints.set_target_distribution(*d);
+
+    inf::Marginal::EvaluatorSet evaluators = constraints.get_marg_evaluators();
+
+    for (std::pair<Num, inf::Marginal::EvaluatorSet::ArenaWidth> const &c : user::get_arena_width_cases(constraints, *d)) {
+        util::logger << "Largest quovec component: " << c.first << util::cr;
+        inf::Quovec const quovec = user::set_random_quovec(constraints, c.first);
+
+        // The same inf::Marginal::EvaluatorSet has to switch to the new width
+        inf::Event const e = inflation->get_random_event();
+        for (Index const i : util::Range(e.size()))
+            evaluators.set_outcome(i, e[i]);
+
+        HARD_ASSERT_EQUAL(evaluators.evaluate_dual_vector(), util::inner_product(constraints.get_inflation_event_quovec(e), quovec))
+        HARD_ASSERT_TRUE(evaluators.get_arena_width() == c.second)
+    }
+
+    util::logger << "The arena is stored with the expected integer widths." << util::cr;
+}
+
+void user::outcome_kernels::run() {
+    // 5 outcomes have no dedicated kernel and exercise the generic fallback
+    for (inf::Outcome const n_outcomes : {inf::Outcome(2), inf::Outcome(3), inf::Outcome(4), inf::Outcome(5)}) {
+        inf::TargetDistr::ConstPtr d = user::get_uniform_triangle_distribution(n_outcomes);
+        inf::Inflation::ConstPtr inflation = std::make_shared<const inf::Inflation>(d, inf::Inflation::Size{2, 2, 2});
+        inf::Outcome const outcome_unknown = inflation->get_network()->get_outcome_unknown();
+
+        for (inf::DualVector::StoreBounds const store_bounds : {inf::DualVector::StoreBounds::yes, inf::DualVector::StoreBounds::no}) {
+            bool const unknown_outcomes = (store_bounds == inf::DualVector::StoreBounds::yes);
+            util::logger << "Outcomes: " << n_outcomes << ", bounds: " << (unknown_outcomes ? "yes" : "no") << util::cr;
+
+            inf::ConstraintSet constraints(inflation, {{"A00,B00,C00", "A11,B11,C11", {}}}, store_bounds);
+            constraints.set_target_distribution(*d);
+
+            inf::Marginal::EvaluatorSet evaluators = constraints.get_marg_evaluators();
+
+            for (std::pair<Num, inf::Marginal::EvaluatorSet::ArenaWidth> const &c : user::get_arena_width_cases(constraints, *d)) {
+                user::set_random_quovec(constraints, c.first);
+
+                // With bounds, the parties after a random one have the unknown outcome, as during a tree search
+                inf::Event e = inflation->get_random_event();
+                if (unknown_outcomes)
+                    std::fill(e.begin() + util::RNG<Index>(0, e.size() - 1).get_rand(), e.end(), outcome_unknown);
+                for (Index const i : util::Range(e.size()))
+                    evaluators.set_outcome(i, e[i]);
+                evaluators.evaluate_dual_vector();
+                HARD_ASSERT_TRUE(evaluators.get_arena_width() == c.second)
+
+                std::vector<Num> scores;
+                for (Index const party : util::Range(e.size())) {
+                    // Every non-empty subset of the outcomes
+                    for (Index const mask : util::Range(Index(1), Index(1) << n_outcomes)) {
+                        std::vector<inf::Outcome> outcomes;
+                        for (inf::Outcome const outcome : util::Range(n_outcomes))
+                            if ((mask >> outcome) & 1)
+                                outcomes.push_back(outcome);
+
+                        evaluators.evaluate_dual_vector_for_outcomes(party, outcomes, scores);
+                        HARD_ASSERT_EQUAL(scores.size(), outcomes.size())
+                        // The underlying inflation event is left unchanged
+                        HARD_ASSERT_TRUE(evaluators.get_inflation_event() == e)
+
+                        for (Index const i : util::Range(outcomes.size())) {
+                            evaluators.set_outcome(party, outcomes[i]);
+                            HARD_ASSERT_EQUAL(scores[i], evaluators.evaluate_dual_vector())
+                        }
+                        evaluators.set_outcome(party, e[party]);
+                    }
+                }
+            }
+        }
+    }
+
+    util::logger << "The outcome kernels agree with inf::Marginal::EvaluatorSet::set_outcome()." << util::cr;
+}
+
 void user::dual_vector_io::run() {
     inf::TargetDistr::ConstPtr d = user::get_ejm_distribution();
 
@@ -817,6 +1022,352 @@ void user::opt_bounds::run() {
 
         util::logger << util::cr;
     }
+
+    // Every valid combination of the tree search options must find the same minimum as the default options above
+    std::vector<inf::Optimizer::ThreadSchedule> const thread_schedules = {
+        inf::Optimizer::ThreadSchedule::static_split,
+        inf::Optimizer::ThreadSchedule::work_stealing,
+    };
+    std::vector<inf::Optimizer::NodeOrder> const node_orders = {
+        inf::Optimizer::NodeOrder::tree,
+        inf::Optimizer::NodeOrder::lower_bound,
+        inf::Optimizer::NodeOrder::best_first,
+    };
+    std::vector<inf::Optimizer::LowerBound> const lower_bounds = {
+        inf::Optimizer::LowerBound::per_term,
+        inf::Optimizer::LowerBound::branched,
+    };
+    std::vector<Index> const n_events_list = {1, 3};
+
+    // The scores of the 3 lowest-scoring events, as found by the first combination
+    std::vector<Num> reference_scores;
+
+    for (inf::DualVector::StoreBounds store_bounds : store_bound_modes) {
+        inf::ConstraintSet::Ptr constraints = std::make_shared<inf::ConstraintSet>(inflation,
+                                                                                   inf::ConstraintSet::Description{{"A00,B00,C00", "A11,B11,C11", {}}},
+                                                                                   store_bounds);
+        constraints->set_target_distribution(*d);
+        constraints->set_dual_vector_from_quovec(dual_vector_quovec);
+
+        for (inf::Optimizer::ThreadSchedule thread_schedule : thread_schedules) {
+            for (inf::Optimizer::NodeOrder node_order : node_orders) {
+                for (inf::Optimizer::LowerBound lower_bound : lower_bounds) {
+                    // Ordering the nodes and branching both need the stored bounds, and best-first needs work stealing
+                    if (store_bounds == inf::DualVector::StoreBounds::no and
+                        (node_order != inf::Optimizer::NodeOrder::tree or lower_bound != inf::Optimizer::LowerBound::per_term))
+                        continue;
+                    if (node_order == inf::Optimizer::NodeOrder::best_first and thread_schedule != inf::Optimizer::ThreadSchedule::work_stealing)
+                        continue;
+
+                    inf::DualVector::log(store_bounds);
+                    util::logger << ", ";
+                    inf::Optimizer::log(thread_schedule);
+                    util::logger << ", ";
+                    inf::Optimizer::log(node_order);
+                    util::logger << ", ";
+                    inf::Optimizer::log(lower_bound);
+                    util::logger << util::cr;
+
+                    inf::Optimizer::Ptr optimizer = inf::Optimizer::get_optimizer(search_mode, constraints, inf::EventTree::IO::none, get_feas_options()->get_n_threads(),
+                                                                                  thread_schedule, node_order, lower_bound);
+
+                    for (Index const n_events : n_events_list) {
+                        inf::Optimizer::Solution sol = optimizer->optimize(inf::Optimizer::StopMode::opt, n_events);
+                        HARD_ASSERT_EQUAL(*previous_score, sol.get_inflation_event_score())
+
+                        inf::Optimizer::ScoredEvents scored_events = sol.get_other_scored_events();
+                        scored_events.insert(scored_events.begin(), inf::Optimizer::ScoredEvent(sol.get_inflation_event_score(), sol.get_inflation_event()));
+                        HARD_ASSERT_EQUAL(scored_events.size(), n_events)
+
+                        std::set<inf::Event> distinct_events;
+                        for (Index const i : util::Range(n_events)) {
+                            HARD_ASSERT_TRUE(distinct_events.insert(scored_events[i].second).second)
+                            if (i > 0)
+                                HARD_ASSERT_LTE(scored_events[i - 1].first, scored_events[i].first)
+                        }
+
+                        if (n_events == n_events_list.back()) {
+                            if (reference_scores.empty()) {
+                                for (inf::Optimizer::ScoredEvent const &scored_event : scored_events)
+                                    reference_scores.push_back(scored_event.first);
+                            }
+
+                            for (Index const i : util::Range(n_events))
+                                HARD_ASSERT_EQUAL(reference_scores[i], scored_events[i].first)
+                        }
+                    }
+                }
+            }
+        }
+    }
+    util::logger << "All the tree search options find the same lowest-scoring events." << util::cr;
+}
+
+void user::test_optimizer_scores(std::function<inf::Optimizer::Ptr(inf::ConstraintSet::Ptr const &)> const &get_optimizer,
+                                 Index const n_steps,
+                                 Index const n_threads) {
+    inf::TargetDistr::ConstPtr const d = user::get_noisy_srb(1, 2);
+    inf::TargetDistr::ConstPtr const other_d = user::get_noisy_srb(1, 3);
+
+    inf::Inflation::ConstPtr inflation = std::make_shared<const inf::Inflation>(d, inf::Inflation::Size{2, 2, 2});
+    util::logger << *inflation << util::cr;
+
+    inf::ConstraintSet::Ptr constraints = std::make_shared<inf::ConstraintSet>(inflation,
+                                                                               inf::ConstraintSet::Description{{"A00,B00,C00", "A11,B11,C11", {}}},
+                                                                               inf::DualVector::StoreBounds::yes);
+    constraints->set_target_distribution(*d);
+
+    inf::Optimizer::Ptr tested_optimizer = get_optimizer(constraints);
+
+    util::RNG<Num> coeff_rng(-10, 10);
+    // Small steps make the previous search relevant
+    util::RNG<Num> step_rng(-1, 1);
+    util::RNG<Index> n_events_rng(1, 3);
+
+    inf::Quovec quovec(constraints->get_quovec_size());
+    for (Num &coeff : quovec)
+        coeff = coeff_rng.get_rand();
+
+    for (Index const step : util::Range(n_steps)) {
+        if (step == n_steps / 2) {
+            util::logger << "Changing the target distribution." << util::cr;
+            constraints->set_target_distribution(*other_d);
+        } else if (step > 0) {
+            for (Num &coeff : quovec)
+                coeff += step_rng.get_rand();
+        }
+        constraints->set_dual_vector_from_quovec(quovec);
+
+        Index const n_events = n_events_rng.get_rand();
+        inf::Optimizer::Solution const tested_sol = tested_optimizer->optimize(inf::Optimizer::StopMode::opt, n_events);
+
+        inf::Optimizer::Ptr fresh_optimizer = inf::Optimizer::get_optimizer(inf::Optimizer::SearchMode::tree_search, constraints,
+                                                                            inf::EventTree::IO::none, n_threads);
+        inf::Optimizer::Solution const fresh_sol = fresh_optimizer->optimize(inf::Optimizer::StopMode::opt, n_events);
+
+        util::logger << "Step " << step << ", " << n_events << " event(s): score " << tested_sol.get_inflation_event_score() << util::cr;
+        HARD_ASSERT_EQUAL(tested_sol.get_inflation_event_score(), fresh_sol.get_inflation_event_score())
+
+        inf::Optimizer::ScoredEvents const &tested_others = tested_sol.get_other_scored_events();
+        inf::Optimizer::ScoredEvents const &fresh_others = fresh_sol.get_other_scored_events();
+        HARD_ASSERT_EQUAL(tested_others.size(), fresh_others.size())
+        for (Index const i : util::Range(tested_others.size()))
+            HARD_ASSERT_EQUAL(tested_others[i].first, fresh_others[i].first)
+    }
+}
+
+void user::opt_reuse::run() {
+    Index const n_threads = get_feas_options()->get_n_threads();
+
+    user::test_optimizer_scores(
+        [n_threads](inf::ConstraintSet::Ptr const &constraints) {
+            return inf::Optimizer::get_optimizer(inf::Optimizer::SearchMode::tree_search, constraints, inf::EventTree::IO::none, n_threads);
+        },
+        20, n_threads);
+
+    util::logger << "The reused search finds the same scores as a fresh search at every step." << util::cr;
+}
+
+void user::sharded_opt::run() {
+    Index const n_threads = get_feas_options()->get_n_threads();
+
+    for (Index const n_processes : {Index(2), Index(3)}) {
+        util::logger << n_processes << " processes" << util::cr;
+
+        // The worker processes are forked anew when the target distribution changes
+        user::test_optimizer_scores(
+            [n_threads, n_processes](inf::ConstraintSet::Ptr const &constraints) {
+                return inf::Optimizer::get_optimizer(inf::Optimizer::SearchMode::tree_search, constraints, inf::EventTree::IO::none, n_threads,
+                                                     inf::Optimizer::ThreadSchedule::work_stealing,
+                                                     inf::Optimizer::NodeOrder::tree,
+                                                     inf::Optimizer::LowerBound::per_term,
+                                                     inf::Optimizer::PreOracle::none,
+                                                     n_processes);
+            },
+            6, n_threads);
+    }
+
+    util::logger << "inf::ShardedOpt finds the same scores as inf::TreeOpt." << util::cr;
+}
+
+void user::local_search::run() {
+    inf::Optimizer::SearchMode const search_mode = inf::Optimizer::SearchMode::tree_search;
+    Index const n_threads = get_feas_options()->get_n_threads();
+
+    LOG_BEGIN_SECTION("Random dual vectors")
+    {
+        inf::TargetDistr::ConstPtr const d = user::get_noisy_srb(1, 2);
+        inf::Inflation::ConstPtr inflation = std::make_shared<const inf::Inflation>(d, inf::Inflation::Size{2, 2, 2});
+        inf::ConstraintSet::Ptr constraints = std::make_shared<inf::ConstraintSet>(inflation,
+                                                                                   inf::ConstraintSet::Description{{"A00,B00,C00", "A11,B11,C11", {}}},
+                                                                                   inf::DualVector::StoreBounds::yes);
+        constraints->set_target_distribution(*d);
+
+        inf::Optimizer::Ptr exact_optimizer = inf::Optimizer::get_optimizer(search_mode, constraints, inf::EventTree::IO::none, n_threads);
+        inf::Optimizer::Ptr heuristic_optimizer = inf::Optimizer::get_optimizer(search_mode, constraints, inf::EventTree::IO::none, n_threads,
+                                                                                inf::Optimizer::ThreadSchedule::work_stealing,
+                                                                                inf::Optimizer::NodeOrder::tree,
+                                                                                inf::Optimizer::LowerBound::per_term,
+                                                                                inf::Optimizer::PreOracle::local_search);
+        inf::LocalSearch local_search(constraints);
+
+        Index const n_steps = 10;
+        util::RNG<Num> coeff_rng(-10, 10);
+        util::RNG<Index> n_events_rng(1, 3);
+        // As in inf::FeasProblem, the seeds are the events found so far
+        std::set<inf::Event> seed_events;
+        Index n_successes = 0;
+
+        for (Index const step : util::Range(n_steps)) {
+            inf::Quovec quovec(constraints->get_quovec_size());
+            for (Num &coeff : quovec)
+                coeff = coeff_rng.get_rand();
+            constraints->set_dual_vector_from_quovec(quovec);
+
+            Index const n_events = n_events_rng.get_rand();
+            Num const minimum = exact_optimizer->optimize(inf::Optimizer::StopMode::opt).get_inflation_event_score();
+
+            inf::LocalSearch::ScoredEvents const local_scored_events = local_search.get_nonpositive_events(seed_events, n_events);
+            util::logger << "Step " << step << ", minimum " << minimum << ": the heuristic found " << local_scored_events.size()
+                         << " of " << n_events << " event(s)" << util::cr;
+            HARD_ASSERT_LTE(local_scored_events.size(), n_events)
+            check_scored_events(*constraints, local_scored_events);
+            for (inf::LocalSearch::ScoredEvent const &scored_event : local_scored_events)
+                HARD_ASSERT_LTE(scored_event.first, 0)
+            if (not local_scored_events.empty())
+                ++n_successes;
+
+            // Whether or not the heuristic succeeds, the optimizer returns events scoring at most zero if there are any
+            inf::Optimizer::Solution const sol = heuristic_optimizer->optimize(inf::Optimizer::StopMode::sat, n_events, seed_events);
+            inf::Optimizer::ScoredEvents const scored_events = get_scored_events(sol);
+            check_scored_events(*constraints, scored_events);
+            if (minimum <= 0) {
+                for (inf::Optimizer::ScoredEvent const &scored_event : scored_events)
+                    HARD_ASSERT_LTE(scored_event.first, 0)
+            } else {
+                HARD_ASSERT_EQUAL(minimum, sol.get_inflation_event_score())
+            }
+
+            for (inf::Optimizer::ScoredEvent const &scored_event : scored_events)
+                seed_events.insert(scored_event.second);
+        }
+
+        // The minima of random dual vectors are very negative, the heuristic cannot miss all of them
+        HARD_ASSERT_LT(0, n_successes)
+    }
+    LOG_END_SECTION
+
+    LOG_BEGIN_SECTION("Nonlocality certificate")
+    {
+        // See user::srb_dual_vector_io, the minimum is then positive, so the heuristic must fail and the exact search must take over
+        Num const vis_denom = 100000;
+        Num const vis_certificate = 41422;
+        std::string const filename = "data/srb_222_certificate";
+        std::string const metadata = "A nonlocality certificate for the Shared Random Bit with visibility " +
+                                     inf::VisProblem::visibility_to_str(vis_certificate, vis_denom) +
+                                     " obtained with inflation size 2x2x2 and all LPI constraints";
+        inf::ConstraintSet::Description const description = {
+            {"A00,B00,C00", "A11,B11,C11", ""},
+            {"A00", "A11,B10,B11,C01,C11"},
+        };
+
+        inf::TargetDistr::ConstPtr const d = user::get_noisy_srb(vis_certificate, vis_denom);
+        inf::Inflation::ConstPtr inflation = std::make_shared<const inf::Inflation>(d, inf::Inflation::Size{2, 2, 2},
+                                                                                    inf::Inflation::UseDistrSymmetries::yes,
+                                                                                    inf::Inflation::PartyOrder::standard,
+                                                                                    description);
+        inf::ConstraintSet::Ptr constraints = std::make_shared<inf::ConstraintSet>(inflation, description, inf::DualVector::StoreBounds::yes);
+        constraints->set_target_distribution(*d);
+        constraints->read_dual_vector_from_file(filename, metadata);
+
+        inf::Optimizer::Ptr exact_optimizer = inf::Optimizer::get_optimizer(search_mode, constraints, inf::EventTree::IO::none, n_threads);
+        inf::Optimizer::Ptr heuristic_optimizer = inf::Optimizer::get_optimizer(search_mode, constraints, inf::EventTree::IO::none, n_threads,
+                                                                                inf::Optimizer::ThreadSchedule::work_stealing,
+                                                                                inf::Optimizer::NodeOrder::tree,
+                                                                                inf::Optimizer::LowerBound::per_term,
+                                                                                inf::Optimizer::PreOracle::local_search);
+
+        inf::Optimizer::Solution const exact_sol = exact_optimizer->optimize(inf::Optimizer::StopMode::opt);
+        util::logger << "The minimum of the certificate is " << exact_sol.get_inflation_event_score() << util::cr;
+        HARD_ASSERT_LT(0, exact_sol.get_inflation_event_score())
+
+        inf::LocalSearch local_search(constraints);
+        HARD_ASSERT_TRUE(local_search.get_nonpositive_events({exact_sol.get_inflation_event()}, 1).empty())
+
+        inf::Optimizer::Solution const sol = heuristic_optimizer->optimize(inf::Optimizer::StopMode::sat, 1, {exact_sol.get_inflation_event()});
+        HARD_ASSERT_EQUAL(exact_sol.get_inflation_event_score(), sol.get_inflation_event_score())
+        check_scored_events(*constraints, get_scored_events(sol));
+    }
+    LOG_END_SECTION
+
+    util::logger << "inf::LocalSearch only returns events scoring at most zero, and the exact search takes over when it fails." << util::cr;
+}
+
+void user::party_order::run() {
+    inf::ConstraintSet::Description const description = {{"A00,B00,C00", "A11,B11,C11", {}}};
+    inf::Optimizer::SearchMode const search_mode = inf::Optimizer::SearchMode::tree_search;
+    Index const n_threads = get_feas_options()->get_n_threads();
+    Index const n_quovecs = 5;
+    util::RNG<Num> coeff_rng(-10, 10);
+
+    for (inf::TargetDistr::ConstPtr const &d : {user::get_noisy_srb(1, 2), user::get_ejm_distribution()}) {
+        LOG_BEGIN_SECTION(d->get_short_name())
+
+        std::vector<inf::ConstraintSet::Ptr> constraint_sets;
+        std::vector<inf::Optimizer::Ptr> optimizers;
+        for (inf::Inflation::PartyOrder const party_order : {inf::Inflation::PartyOrder::standard, inf::Inflation::PartyOrder::optimized}) {
+            inf::Inflation::ConstPtr inflation = std::make_shared<const inf::Inflation>(d, inf::Inflation::Size{2, 2, 2},
+                                                                                        inf::Inflation::UseDistrSymmetries::yes,
+                                                                                        party_order,
+                                                                                        description);
+            inf::Inflation::log(party_order);
+            util::logger << ":";
+            for (Index const party : util::Range(inflation->get_n_parties()))
+                util::logger << " " << inflation->get_party_name(party);
+            util::logger << util::cr;
+
+            inf::ConstraintSet::Ptr constraints = std::make_shared<inf::ConstraintSet>(inflation, description, inf::DualVector::StoreBounds::yes);
+            constraints->set_target_distribution(*d);
+            constraint_sets.push_back(constraints);
+            optimizers.push_back(inf::Optimizer::get_optimizer(search_mode, constraints, inf::EventTree::IO::none, n_threads));
+        }
+
+        inf::Inflation const &standard_inflation = *constraint_sets[0]->get_inflation();
+        inf::Inflation const &optimized_inflation = *constraint_sets[1]->get_inflation();
+        inf::EventTree const &standard_symtree = standard_inflation.get_symtree(inf::EventTree::IO::none, n_threads);
+        inf::EventTree const &optimized_symtree = optimized_inflation.get_symtree(inf::EventTree::IO::none, n_threads);
+
+        // The relabeled symmetry group has the same orbits, only the shape of the tree changes
+        util::logger << "Cached nodes: " << standard_symtree.get_n_nodes_cached() << " (standard), "
+                     << optimized_symtree.get_n_nodes_cached() << " (optimized)" << util::cr;
+        HARD_ASSERT_EQUAL(standard_symtree.get_n_leaves(), optimized_symtree.get_n_leaves())
+
+        for (Index const i : util::Range(n_quovecs)) {
+            // The quovecs refer to the inflation parties by their names, so the same quovec describes the same dual vector
+            inf::Quovec quovec(constraint_sets[0]->get_quovec_size());
+            for (Num &coeff : quovec)
+                coeff = coeff_rng.get_rand();
+            for (inf::ConstraintSet::Ptr const &constraints : constraint_sets)
+                constraints->set_dual_vector_from_quovec(quovec);
+
+            // The same event, with the parties listed in each order, has the same score
+            inf::Event const standard_event = standard_inflation.get_random_event();
+            inf::Event optimized_event(standard_event.size());
+            for (Index const party : util::Range(standard_event.size()))
+                optimized_event[optimized_inflation.get_party_index(standard_inflation.get_party_name(party))] = standard_event[party];
+            HARD_ASSERT_EQUAL(util::inner_product(constraint_sets[0]->get_inflation_event_quovec(standard_event), quovec),
+                              util::inner_product(constraint_sets[1]->get_inflation_event_quovec(optimized_event), quovec))
+
+            Num const standard_minimum = optimizers[0]->optimize(inf::Optimizer::StopMode::opt).get_inflation_event_score();
+            Num const optimized_minimum = optimizers[1]->optimize(inf::Optimizer::StopMode::opt).get_inflation_event_score();
+            util::logger << "Quovec " << i << ": minimum " << standard_minimum << util::cr;
+            HARD_ASSERT_EQUAL(standard_minimum, optimized_minimum)
+        }
+
+        LOG_END_SECTION
+    }
+
+    util::logger << "The standard and optimized party orders give the same minima." << util::cr;
 }
 
 void user::opt_time::run() {
@@ -1,7 +1,12 @@
 #pragma once
 
+#include "../../inf/constraints/constraint_set.h"
 #include "../../inf/inf_problem/target_distr.h"
+#include "../../inf/optimization/optimizer.h"
 #include "../application.h"
+
+// For std::function
+#include <functional>
 /*! \file */
 
 /*! \defgroup misc_tests Miscellaneous tests
@@ -22,6 +27,19 @@ The evaluation is compared using different methods for consistency checks.
 \param d This distribution is used to define an inflation problem for which inner products will be evaluated. */
 void test_dual_vector_eval(inf::TargetDistr::ConstPtr const &d);
 
+/*! \brief This function tests that an inf::Optimizer finds the same lowest-scoring events as a fresh tree search
+\details The inf::Optimizer returned by \p get_optimizer is created once, and then queried at each of the \p n_steps steps
+for between 1 and 3 lowest-scoring events of the constraint `{"A00,B00,C00", "A11,B11,C11"}` of the 2x2x2 inflation of user::get_noisy_srb(1, 2).
+The quovec starts at random and moves by small random steps, and the target distribution changes to user::get_noisy_srb(1, 3) halfway through,
+so that the inf::Optimizer has to handle both kinds of updates.
+The scores of its events must be those found by a fresh inf::Optimizer::SearchMode::tree_search created at each step.
+\param get_optimizer Returns the inf::Optimizer to test for the given inf::ConstraintSet
+\param n_steps The number of dual vectors for which the inf::Optimizer is queried
+\param n_threads The number of threads of the fresh tree searches */
+void test_optimizer_scores(std::function<inf::Optimizer::Ptr(inf::ConstraintSet::Ptr const &)> const &get_optimizer,
+                           Index const n_steps,
+                           Index const n_threads);
+
 /*! \brief We use this to conveniently print events in our latex source code format */
 void print_event_latex_format(inf::Inflation const &inflation, inf::Event const &event);
 
@@ -96,6 +114,25 @@ class dual_vector_bounds : public user::Application {
     void run() override;
 };
 
+/*! \brief Tests the integer type with which inf::Marginal::EvaluatorSet stores its arena
+ * \details Quovecs with small, mid-range and nearly maximal components (see inf::ConstraintSet::get_max_dual_vector_component())
+ * must be stored with `std::int16_t`, `std::int32_t` and ::Num respectively, and still evaluate to the inner product of the quovecs. */
+class arena_width : public user::Application {
+  public:
+    arena_width() : user::Application("arena_width", "Tests the integer width of the arena of an inf::Marginal::EvaluatorSet", true) {}
+    void run() override;
+};
+
+/*! \brief Tests the kernels of inf::Marginal::EvaluatorSet for each number of outcomes
+ * \details For every inflation party and every subset of outcomes, inf::Marginal::EvaluatorSet::evaluate_dual_vector_for_outcomes()
+ * must agree with inf::Marginal::EvaluatorSet::set_outcome() followed by inf::Marginal::EvaluatorSet::evaluate_dual_vector(),
+ * with and without bounds, and for each inf::Marginal::EvaluatorSet::ArenaWidth. */
+class outcome_kernels : public user::Application {
+  public:
+    outcome_kernels() : user::Application("outcome_kernels", "Tests the outcome kernels of an inf::Marginal::EvaluatorSet", true) {}
+    void run() override;
+};
+
 /*! \brief Tests the mechanism that reads/writes an inf::DualVector to disk */
 class dual_vector_io : public user::Application {
   public:
@@ -103,13 +140,49 @@ class dual_vector_io : public user::Application {
     void run() override;
 };
 
-/*! \brief Tests the mechanism that uses the bounds of an inf::DualVector to speed up the optimizations of inner products. */
+/*! \brief Tests the mechanism that uses the bounds of an inf::DualVector to speed up the optimizations of inner products.
+ * \details Every valid combination of inf::Optimizer::ThreadSchedule, inf::Optimizer::NodeOrder and inf::Optimizer::LowerBound must then find the same
+ * lowest-scoring events, asking for one or several distinct events. */
 class opt_bounds : public user::Application {
   public:
     opt_bounds() : user::Application("opt_bounds", "Tests the use of bounds of an inf::DualVector by an inf::Optimizer", true) {}
     void run() override;
 };
 
+/*! \brief Tests that an inf::TreeOpt reusing its previous search finds the same minimum as a fresh inf::TreeOpt
+ * \details See user::test_optimizer_scores(). */
+class opt_reuse : public user::Application {
+  public:
+    opt_reuse() : user::Application("opt_reuse", "Tests the reuse of the previous search by an inf::TreeOpt", true) {}
+    void run() override;
+};
+
+/*! \brief Tests that an inf::ShardedOpt finds the same minimum as an inf::TreeOpt searching the whole tree
+ * \details This is done with 2 and 3 worker processes, see user::test_optimizer_scores(). */
+class sharded_opt : public user::Application {
+  public:
+    sharded_opt() : user::Application("sharded_opt", "Tests inf::ShardedOpt against inf::TreeOpt", true) {}
+    void run() override;
+};
+
+/*! \brief Tests inf::LocalSearch and its use by an inf::Optimizer with inf::Optimizer::PreOracle::local_search
+ * \details On random dual vectors, the events returned in sat mode must score at most zero, be distinct and sorted.
+ * On a nonlocality certificate, the heuristic must fail and the inf::Optimizer must return the minimum of the exact tree search. */
+class local_search : public user::Application {
+  public:
+    local_search() : user::Application("local_search", "Tests inf::LocalSearch", true) {}
+    void run() override;
+};
+
+/*! \brief Tests inf::Inflation::PartyOrder::optimized against inf::Inflation::PartyOrder::standard
+ * \details For the noisy SRB and EJM distributions on the 2x2x2 inflation, both orders must give inf::EventTree with the same number of leaves,
+ * the same scores for the same event, and the same tree search minima for random quovecs. */
+class party_order : public user::Application {
+  public:
+    party_order() : user::Application("party_order", "Tests the optimized ordering of the inflation parties", true) {}
+    void run() override;
+};
+
 /*! \brief To test the time that an inf::Optimizer takes for various options. This one takes more time to execute. */
 class opt_time : public user::Application {
   public:
@@ -12,6 +12,7 @@ user::InfCLI::InfCLI(int argc, char **argv)
       m_target_application_name(""),
       m_log_level(),
       m_n_threads(),
+      m_n_processes(),
       m_symtree_io(),
       m_visibility_param() {}
 
@@ -29,6 +30,9 @@ void user::InfCLI::init() {
     m_n_threads = m_base_cli.extract_uint_option("threads", 1);
     m_usage += "[--threads {1,2,...}] ";
 
+    m_n_processes = m_base_cli.extract_uint_option("processes", 1);
+    m_usage += "[--processes {1,2,...}] ";
+
     m_symtree_io = m_base_cli.extract_str_option("symtree-io", "read");
     m_usage += "[--symtree-io {none,read,write}] ";
 
@@ -50,6 +54,8 @@ void user::InfCLI::log() const {
         << m_log_level << util::cr
         << util::begin_comment << "--threads = " << util::end_comment
         << m_n_threads << util::cr
+        << util::begin_comment << "--processes = " << util::end_comment
+        << m_n_processes << util::cr
         << util::begin_comment << "--symtree-io = " << util::end_comment
         << m_symtree_io << util::cr
         << util::begin_comment << "--vis = " << util::end_comment
@@ -77,6 +83,12 @@ unsigned int user::InfCLI::get_n_threads() const {
     return m_n_threads;
 }
 
+unsigned int user::InfCLI::get_n_processes() const {
+    HARD_ASSERT_TRUE(m_initialized)
+    HARD_ASSERT_LT(0, m_n_processes)
+    return m_n_processes;
+}
+
 inf::EventTree::IO user::InfCLI::get_symtree_io() const {
     HARD_ASSERT_TRUE(m_initialized)
 
@@ -33,6 +33,7 @@ class InfCLI : public util::Loggable {
     std::string const &get_target_application_name() const;
     unsigned int get_log_level() const;
     unsigned int get_n_threads() const;
+    unsigned int get_n_processes() const;
     inf::EventTree::IO get_symtree_io() const;
     unsigned int get_visibility_param() const;
 
@@ -46,6 +47,7 @@ class InfCLI : public util::Loggable {
     std::string m_target_application_name;
     unsigned int m_log_level;
     unsigned int m_n_threads;
+    unsigned int m_n_processes;
 
     std::string m_symtree_io;
 
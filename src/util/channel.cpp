@@ -0,0 +1,70 @@
+#include "channel.h"
+
+#include "debug.h"
+
+// For socketpair, send, recv, etc
+#include <sys/socket.h>
+#include <unistd.h>
+
+// For errno and EINTR
+#include <cerrno>
+
+util::Channel::Channel(int file_descriptor)
+    : m_file_descriptor(file_descriptor) {
+    HARD_ASSERT_LTE(0, m_file_descriptor)
+}
+
+util::Channel::~Channel() {
+    close(m_file_descriptor);
+}
+
+std::pair<util::Channel::UniquePtr, util::Channel::UniquePtr> util::Channel::get_local_pair() {
+    int file_descriptors[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, file_descriptors) != 0)
+        THROW_ERROR("Could not create a Unix-domain socket pair")
+
+    return {std::make_unique<util::Channel>(file_descriptors[0]),
+            std::make_unique<util::Channel>(file_descriptors[1])};
+}
+
+void util::Channel::write_bytes(void const *data, Index size) {
+    char const *bytes = static_cast<char const *>(data);
+
+    while (size > 0) {
+        // MSG_NOSIGNAL: a closed peer is reported as an error rather than killing the process with SIGPIPE
+        ssize_t const n_sent = send(m_file_descriptor, bytes, size, MSG_NOSIGNAL);
+        if (n_sent < 0) {
+            if (errno == EINTR)
+                continue;
+            THROW_ERROR("Could not write to the util::Channel")
+        }
+
+        bytes += n_sent;
+        size -= static_cast<Index>(n_sent);
+    }
+}
+
+bool util::Channel::read_bytes(void *data, Index size) {
+    char *bytes = static_cast<char *>(data);
+    bool received_any = false;
+
+    while (size > 0) {
+        ssize_t const n_received = recv(m_file_descriptor, bytes, size, 0);
+        if (n_received < 0) {
+            if (errno == EINTR)
+                continue;
+            THROW_ERROR("Could not read from the util::Channel")
+        }
+        if (n_received == 0) {
+            if (not received_any)
+                return false;
+            THROW_ERROR("The util::Channel was closed in the middle of a message")
+        }
+
+        received_any = true;
+        bytes += n_received;
+        size -= static_cast<Index>(n_received);
+    }
+
+    return true;
+}
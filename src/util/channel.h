@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../types.h"
+
+// For std::unique_ptr
+#include <memory>
+// For std::is_trivially_copyable
+#include <type_traits>
+// For std::pair
+#include <utility>
+#include <vector>
+
+/*! \file */
+
+namespace util {
+
+/*! \ingroup serialization
+ * \brief A bidirectional byte stream over a connected socket, used to exchange messages with another process
+ * \details The socket can be a Unix-domain socket, as obtained with util::Channel::get_local_pair() to talk to a child process,
+ * or a TCP socket connected to another host: the util::Channel only sees a file descriptor.
+ * Values are sent as raw bytes, so that both ends must run the same binary on the same architecture.
+ *
+ * The reading methods return `false` if the other end closed the connection before sending anything,
+ * which is how a process learns that its peer is done. Any other failure throws an error. */
+class Channel {
+  public:
+    typedef std::unique_ptr<util::Channel> UniquePtr;
+
+    /*! \brief Takes ownership of the connected socket \p file_descriptor, which is closed on destruction */
+    Channel(int file_descriptor);
+    //! \cond
+    Channel(Channel const &other) = delete;
+    Channel(Channel &&other) = delete;
+    Channel &operator=(Channel const &other) = delete;
+    Channel &operator=(Channel &&other) = delete;
+    //! \endcond
+    ~Channel();
+
+    /*! \brief Returns the two ends of a new Unix-domain socket
+     * \details Typically, one end is kept by a process and the other one by the child process that it forks. */
+    static std::pair<util::Channel::UniquePtr, util::Channel::UniquePtr> get_local_pair();
+
+    /*! \brief Sends the \p size bytes starting at \p data */
+    void write_bytes(void const *data, Index size);
+    /*! \brief Receives \p size bytes into \p data
+     * \return `false` if the other end closed the connection before sending any byte */
+    bool read_bytes(void *data, Index size);
+
+    /*! \brief Sends \p value as raw bytes */
+    template <typename T>
+    void write(T const &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "util::Channel only sends trivially copyable values");
+        write_bytes(&value, sizeof(T));
+    }
+    /*! \brief Receives a value sent by util::Channel::write()
+     * \return `false` if the other end closed the connection */
+    template <typename T>
+    bool read(T &value) {
+        static_assert(std::is_trivially_copyable<T>::value, "util::Channel only receives trivially copyable values");
+        return read_bytes(&value, sizeof(T));
+    }
+
+    /*! \brief Sends the size of \p values followed by its elements */
+    template <typename T>
+    void write_vector(std::vector<T> const &values) {
+        static_assert(std::is_trivially_copyable<T>::value, "util::Channel only sends trivially copyable values");
+        write(static_cast<Index>(values.size()));
+        write_bytes(values.data(), values.size() * sizeof(T));
+    }
+    /*! \brief Receives a vector sent by util::Channel::write_vector()
+     * \return `false` if the other end closed the connection */
+    template <typename T>
+    bool read_vector(std::vector<T> &values) {
+        static_assert(std::is_trivially_copyable<T>::value, "util::Channel only receives trivially copyable values");
+        Index size = 0;
+        if (not read(size))
+            return false;
+        values.resize(size);
+        return size == 0 or read_bytes(values.data(), size * sizeof(T));
+    }
+
+  private:
+    /*! \brief The connected socket */
+    int m_file_descriptor;
+};
+
+} // namespace util
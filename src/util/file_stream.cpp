@@ -41,21 +41,24 @@ Index const util::FileStream::version = 5;
 
 util::FileStream::FileStream(bool is_reading, util::FileStream::Format format)
     : m_is_reading(is_reading),
-      m_extension(""),
-      m_format(format) {
+      m_extension(util::FileStream::get_extension(format)),
+      m_format(format) {}
 
+std::string util::FileStream::get_extension(util::FileStream::Format format) {
     switch (format) {
     case util::FileStream::Format::binary:
-        m_extension = ".binary";
-        break;
+        return ".binary";
     case util::FileStream::Format::text:
-        m_extension = ".txt";
-        break;
+        return ".txt";
     default:
         THROW_ERROR("switch")
     }
 }
 
+bool util::FileStream::exists(std::string const &filename, util::FileStream::Format format) {
+    return std::ifstream(filename + util::FileStream::get_extension(format)).is_open();
+}
+
 bool util::FileStream::is_reading() const {
     return m_is_reading;
 }
@@ -115,6 +115,11 @@ class FileStream {
      * when reading data to verify that we have not changed the read/write format without knowing. */
     static Index const version;
 
+    /*! \brief The extension that is appended to the filenames of the streams of the given \p format */
+    static std::string get_extension(util::FileStream::Format format);
+    /*! \brief Checks whether the file \p filename (without extension) can be read by a util::InputFileStream in the given \p format */
+    static bool exists(std::string const &filename, util::FileStream::Format format);
+
     /*! \brief A stream is either reading or writing, and is either in binary or text format */
     FileStream(bool reading, util::FileStream::Format format);
     virtual ~FileStream() {}
@@ -0,0 +1,51 @@
+#include "mapped_file.h"
+
+#include "debug.h"
+
+// For open, fstat, mmap, etc
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+util::MappedFile::MappedFile(std::string const &filename)
+    : m_data(nullptr),
+      m_size(0) {
+
+    int const file_descriptor = open(filename.c_str(), O_RDONLY);
+    if (file_descriptor < 0)
+        THROW_ERROR("Could not open the file " + filename)
+
+    struct stat file_stat;
+    if (fstat(file_descriptor, &file_stat) != 0 or file_stat.st_size <= 0) {
+        close(file_descriptor);
+        THROW_ERROR("Could not determine the size of the file " + filename)
+    }
+    m_size = static_cast<Index>(file_stat.st_size);
+
+    m_data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+    // The mapping remains valid after closing the file
+    close(file_descriptor);
+
+    if (m_data == MAP_FAILED) {
+        m_data = nullptr;
+        THROW_ERROR("Could not map the file " + filename + " into memory")
+    }
+}
+
+util::MappedFile::~MappedFile() {
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+}
+
+bool util::MappedFile::exists(std::string const &filename) {
+    return access(filename.c_str(), R_OK) == 0;
+}
+
+char const *util::MappedFile::get_data() const {
+    return static_cast<char const *>(m_data);
+}
+
+Index util::MappedFile::get_size() const {
+    return m_size;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../types.h"
+#include <string>
+
+/*! \file */
+
+namespace util {
+
+/*! \ingroup serialization
+ * \brief A read-only view of a whole file mapped into memory
+ * \details Contrary to util::InputFileStream, nothing is parsed or copied: the pages of the file are loaded
+ * lazily by the operating system, and are shared with every other process that maps the same file.
+ * This is used for instance by inf::EventTree::read_image() to work directly on the mapped memory.
+ *
+ * The file is unmapped when the util::MappedFile is destroyed, so pointers obtained from util::MappedFile::get_data()
+ * must not outlive it. */
+class MappedFile {
+  public:
+    /*! \brief Maps the file \p filename (including its extension) into memory
+     * \details Throws an error if the file cannot be opened, is empty, or cannot be mapped. */
+    MappedFile(std::string const &filename);
+    //! \cond
+    MappedFile(MappedFile const &other) = delete;
+    MappedFile(MappedFile &&other) = delete;
+    MappedFile &operator=(MappedFile const &other) = delete;
+    MappedFile &operator=(MappedFile &&other) = delete;
+    //! \endcond
+    ~MappedFile();
+
+    /*! \brief Checks whether \p filename (including its extension) can be opened for reading */
+    static bool exists(std::string const &filename);
+
+    /*! \brief The first byte of the mapped file
+     * \details The mapping is page-aligned, so that this pointer is suitably aligned for any arithmetic type. */
+    char const *get_data() const;
+    /*! \brief The size of the mapped file in bytes */
+    Index get_size() const;
+
+  private:
+    /*! \brief The start of the mapping */
+    void *m_data;
+    /*! \brief The size of the mapping in bytes */
+    Index m_size;
+};
+
+} // namespace util
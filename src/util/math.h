@@ -56,6 +56,18 @@ T pow(T x, T n) {
     return ret;
 }
 
+/*! \ingroup maths
+    \brief Rounds up an unsigned integer to a multiple of another one
+    \details This is typically used to pad a number of bytes for alignment.
+    \param x the integer to round up
+    \param multiple strictly positive
+    \return the smallest multiple of \p multiple that is \f$\geq x\f$ */
+template <typename T>
+T round_up(T x, T multiple) {
+    ASSERT_LT(0, multiple)
+    return ((x + multiple - 1) / multiple) * multiple;
+}
+
 /*! \ingroup maths
     \brief Sums the element of a std::vector
     \details The output should fit in the element type.
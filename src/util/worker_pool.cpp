@@ -0,0 +1,95 @@
+#include "worker_pool.h"
+
+#include "debug.h"
+#include "range.h"
+
+util::WorkerPool::WorkerPool(Index n_threads, Task const &task)
+    : m_task(task),
+      m_mutex(),
+      m_start_condition(),
+      m_done_condition(),
+      m_generation(0),
+      m_n_running(0),
+      m_stop(false),
+      m_exceptions(n_threads),
+      m_threads{} {
+
+    HARD_ASSERT_LT(Index(0), n_threads)
+
+    m_threads.reserve(n_threads - 1);
+    for (Index const thread_index : util::Range(Index(1), n_threads))
+        m_threads.emplace_back(&util::WorkerPool::thread_loop, this, thread_index);
+}
+
+util::WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> const lock(m_mutex);
+        m_stop = true;
+    }
+    m_start_condition.notify_all();
+
+    for (std::thread &thread : m_threads)
+        thread.join();
+}
+
+void util::WorkerPool::run() {
+    {
+        std::lock_guard<std::mutex> const lock(m_mutex);
+        m_n_running = m_threads.size();
+        ++m_generation;
+    }
+    m_start_condition.notify_all();
+
+    // The calling thread does its share of the work
+    run_task(0);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_condition.wait(lock, [this]() { return m_n_running == 0; });
+    }
+
+    std::exception_ptr first_exception = nullptr;
+    for (std::exception_ptr &exception : m_exceptions) {
+        if (first_exception == nullptr)
+            first_exception = exception;
+        exception = nullptr;
+    }
+
+    if (first_exception != nullptr)
+        std::rethrow_exception(first_exception);
+}
+
+void util::WorkerPool::thread_loop(Index thread_index) {
+    Index last_generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_condition.wait(lock, [this, last_generation]() { return m_stop or m_generation != last_generation; });
+
+            if (m_stop)
+                return;
+
+            last_generation = m_generation;
+        }
+
+        run_task(thread_index);
+
+        bool all_done = false;
+        {
+            std::lock_guard<std::mutex> const lock(m_mutex);
+            --m_n_running;
+            all_done = (m_n_running == 0);
+        }
+        if (all_done)
+            m_done_condition.notify_one();
+    }
+}
+
+void util::WorkerPool::run_task(Index thread_index) {
+    try {
+        m_task(thread_index);
+    } catch (...) {
+        m_exceptions[thread_index] = std::current_exception();
+    }
+}
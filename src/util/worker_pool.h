@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../types.h"
+
+// For std::condition_variable
+#include <condition_variable>
+// For std::exception_ptr
+#include <exception>
+// For std::function
+#include <functional>
+// For std::mutex
+#include <mutex>
+// For std::thread
+#include <thread>
+#include <vector>
+
+/*! \file */
+
+namespace util {
+
+/*! \ingroup misc
+ * \brief A fixed set of threads that repeatedly run the same task
+ * \details This is meant for tasks that are run many times in a row, such as the tree search of inf::TreeOpt,
+ * which is performed at every Frank-Wolfe iteration: the threads are created once, and are then merely woken up by util::WorkerPool::run().
+ *
+ * The calling thread of util::WorkerPool::run() takes part in the work as the thread with index `0`,
+ * so that a util::WorkerPool with a single thread does not create any thread. */
+class WorkerPool {
+  public:
+    /*! \brief The task run by each thread, which receives the index of the thread, between `0` and `n_threads-1` */
+    typedef std::function<void(Index)> Task;
+
+    /*! \brief Creates the `n_threads-1` threads that will wait for util::WorkerPool::run()
+     * \param n_threads The number of threads running \p task, including the calling thread of util::WorkerPool::run()
+     * \param task The task run by each thread on each call to util::WorkerPool::run() */
+    WorkerPool(Index n_threads, Task const &task);
+    //! \cond
+    WorkerPool(WorkerPool const &other) = delete;
+    WorkerPool(WorkerPool &&other) = delete;
+    WorkerPool &operator=(WorkerPool const &other) = delete;
+    WorkerPool &operator=(WorkerPool &&other) = delete;
+    //! \endcond
+    /*! \brief Stops and joins the threads */
+    ~WorkerPool();
+
+    /*! \brief Runs the task on all the threads, and returns once they are all done
+     * \details If the task throws in some thread, the exception is rethrown here once all threads are done. */
+    void run();
+
+  private:
+    /*! \brief The task run by each thread */
+    Task const m_task;
+    /*! \brief Protects the members below */
+    std::mutex m_mutex;
+    /*! \brief Wakes up the threads when `m_generation` is incremented or `m_stop` is set */
+    std::condition_variable m_start_condition;
+    /*! \brief Notifies util::WorkerPool::run() when `m_n_running` reaches zero */
+    std::condition_variable m_done_condition;
+    /*! \brief The number of calls to util::WorkerPool::run(), which lets each thread know that it has a new round of work */
+    Index m_generation;
+    /*! \brief The number of threads (other than the calling thread) that have not yet finished the current round */
+    Index m_n_running;
+    /*! \brief Set on destruction to let the threads return */
+    bool m_stop;
+    /*! \brief The exception thrown by each thread during the current round, if any */
+    std::vector<std::exception_ptr> m_exceptions;
+    /*! \brief The threads `1, ..., n_threads-1` */
+    std::vector<std::thread> m_threads;
+
+    /*! \brief The loop run by the thread \p thread_index, waiting for rounds of work until `m_stop` is set */
+    void thread_loop(Index thread_index);
+    /*! \brief Runs `m_task` on \p thread_index, storing any exception in `m_exceptions` */
+    void run_task(Index thread_index);
+};
+
+} // namespace util